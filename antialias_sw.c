@@ -0,0 +1,102 @@
+#include <stdlib.h>
+
+#include "antialias_sw.h"
+
+// Position in [0, 1) of the sample in cell i of a jitter pattern, from a
+// multiplicative hash so that the pattern is fixed
+static double jitter(unsigned i)
+{
+  return ((i * 2654435761u) >> 16) / 65536.0;
+}
+
+// Row-major indices of the pixels whose count differs from the one left,
+// right, above or below, in increasing order; returns how many there are
+static size_t edgePixels(const view_t* view, const uint32_t* iterations,
+                         uint32_t* indices)
+{
+  uint32_t width = view->width, height = view->height;
+  size_t count = 0;
+  for(uint32_t y = 0; y < height; y++)
+  {
+    const uint32_t* row = iterations + (size_t)y*width;
+    for(uint32_t x = 0; x < width; x++)
+    {
+      uint32_t n = row[x];
+      bool edge = (x > 0 && row[x - 1] != n)
+                  || (x + 1 < width && row[x + 1] != n)
+                  || (y > 0 && row[x - (long)width] != n)
+                  || (y + 1 < height && row[x + width] != n);
+      if(edge)
+        indices[count++] = (uint32_t)((size_t)y*width + x);
+    }
+  }
+  return count;
+}
+
+size_t antialiasFrame(const view_t* view, const uint32_t* iterations,
+                      const palette_t* palette, unsigned grid,
+                      uint32_t* pixels)
+{
+  if(grid < 2 || grid > ANTIALIAS_MAX_GRID)
+    return 0;
+
+  size_t pixel_count = (size_t)view->width * view->height;
+  uint32_t* indices = malloc(pixel_count * sizeof(uint32_t));
+  if(indices == NULL)
+    return 0;
+  size_t count = edgePixels(view, iterations, indices);
+
+  // samples of one cell for every refined pixel, and the colour sums
+  uint32_t* counts = malloc(count * sizeof(uint32_t));
+  uint32_t* colours = malloc(count * sizeof(uint32_t));
+  float* magnitudes = palette != NULL ? malloc(count * sizeof(float)) : NULL;
+  uint32_t* sums = calloc(count * 3, sizeof(uint32_t));
+  bool ok = count > 0 && counts != NULL && colours != NULL && sums != NULL
+            && (palette == NULL || magnitudes != NULL);
+
+  // the samples are coloured as a one-row image of their own
+  view_t strip = *view;
+  strip.width = count;
+  strip.height = 1;
+
+  for(unsigned cell = 0; ok && cell < grid*grid; cell++)
+  {
+    // offset from the pixel centre, where its own count was taken
+    double dx = (cell % grid + jitter(2*cell)) / grid - 0.5;
+    double dy = (cell / grid + jitter(2*cell + 1)) / grid - 0.5;
+    view_t sample = *view;
+    offsetView(&sample, dx, dy);
+
+    computePixels(&sample, indices, count, counts, magnitudes);
+    ok = !renderCancelled();
+    if(!ok)
+      break;
+    if(palette != NULL)
+      colourSmooth(&strip, counts, magnitudes, palette, colours);
+    else
+      colourIterations(&strip, counts, colours);
+
+    for(size_t i = 0; i < count; i++)
+    {
+      sums[3*i] += colours[i] >> 16 & 0xff;
+      sums[3*i + 1] += colours[i] >> 8 & 0xff;
+      sums[3*i + 2] += colours[i] & 0xff;
+    }
+  } // for
+
+  if(ok)
+  {
+    unsigned samples = grid*grid;
+    for(size_t i = 0; i < count; i++)
+      pixels[indices[i]] = (sums[3*i] + samples/2) / samples << 16
+                           | (sums[3*i + 1] + samples/2) / samples << 8
+                           | (sums[3*i + 2] + samples/2) / samples;
+  }
+
+  free(indices);
+  free(counts);
+  free(colours);
+  free(magnitudes);
+  free(sums);
+  return ok ? count : 0;
+}
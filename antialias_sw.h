@@ -0,0 +1,36 @@
+#ifndef ANTIALIAS_SW_H
+#define ANTIALIAS_SW_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "render_sw.h"
+#include "palette_sw.h"
+
+/*
+  Adaptive antialiasing. A frame only aliases where the count changes from
+  one pixel to the next: inside a band, or inside the set, every sample of
+  a pixel would come out the same. So only pixels whose count differs from
+  one of their four neighbours' are supersampled, on a jittered grid: the
+  pixel is cut into grid x grid cells and each cell is sampled at a random
+  point inside it, and the pixel gets the average colour of its samples.
+  That costs grid^2 samples per refined pixel rather than per pixel. The
+  jitter is the same for every pixel and every frame, so a frame always
+  comes out the same; each cell's samples are iterated together, as the
+  pixels of the view moved by that cell's offset (see offsetView()).
+*/
+
+// Largest grid, i.e. 64 samples per pixel
+#define ANTIALIAS_MAX_GRID 8
+
+// Supersamples the pixels of a frame that sit on an edge of its counts
+// iterations with grid x grid samples each (2 to ANTIALIAS_MAX_GRID), in
+// place in its colours pixels. Samples are coloured with colourSmooth() and
+// palette, or with colourIterations() if palette is NULL, as the frame
+// was. Returns the number of pixels refined; pixels is left alone if the
+// buffers can't be allocated or the render is cancelled.
+size_t antialiasFrame(const view_t* view, const uint32_t* iterations,
+                      const palette_t* palette, unsigned grid,
+                      uint32_t* pixels);
+
+#endif // ANTIALIAS_SW_H
@@ -0,0 +1,177 @@
+#include <ctype.h>
+#include <math.h>
+#include <string.h>
+
+#include "bigfix_sw.h"
+
+// Fraction bits kept beyond the pixel spacing, they absorb the rounding
+// the reference orbit accumulates over many iterations
+#define BIGFIX_GUARD_BITS 64
+
+typedef unsigned __int128 uint128_t;
+
+unsigned bigfixLimbsFor(double step)
+{
+  double bits = -log2(step) + BIGFIX_GUARD_BITS;
+  unsigned limbs = 1 + (unsigned)ceil((bits > 0 ? bits : 0) / 64);
+  return limbs < BIGFIX_LIMBS ? limbs : BIGFIX_LIMBS;
+}
+
+bool bigfixNegative(const bigfix_t* a)
+{
+  return (int64_t)a->limb[0] < 0;
+}
+
+static void negate(bigfix_t* a, unsigned limbs)
+{
+  unsigned carry = 1;
+  for(int i = limbs - 1; i >= 0; i--)
+  {
+    a->limb[i] = ~a->limb[i] + carry;
+    carry = carry && a->limb[i] == 0;
+  }
+}
+
+static void clearFrom(bigfix_t* a, unsigned limbs)
+{
+  memset(a->limb + limbs, 0, (BIGFIX_LIMBS - limbs) * sizeof(uint64_t));
+}
+
+void bigfixFromDouble(bigfix_t* r, double value)
+{
+  double magnitude = fabs(value);
+  double integer = floor(magnitude);
+  double fraction = magnitude - integer;   // exact
+
+  memset(r, 0, sizeof(*r));
+  r->limb[0] = (uint64_t)integer;
+  for(unsigned i = 1; i < BIGFIX_LIMBS && fraction != 0; i++)
+  {
+    fraction = ldexp(fraction, 64);
+    double part = floor(fraction);
+    r->limb[i] = (uint64_t)part;
+    fraction -= part;
+  }
+
+  if(value < 0)
+    negate(r, BIGFIX_LIMBS);
+}
+
+double bigfixToDouble(const bigfix_t* a)
+{
+  bigfix_t magnitude = *a;
+  if(bigfixNegative(a))
+    negate(&magnitude, BIGFIX_LIMBS);
+
+  // least significant first so that the small parts are not lost
+  double value = 0;
+  for(int i = BIGFIX_LIMBS - 1; i >= 0; i--)
+    value += ldexp((double)magnitude.limb[i], -64*i);
+  return bigfixNegative(a) ? -value : value;
+}
+
+// a = a / 10, a must not be negative
+static void divideBy10(bigfix_t* a)
+{
+  uint64_t remainder = 0;
+  for(unsigned i = 0; i < BIGFIX_LIMBS; i++)
+  {
+    uint128_t part = ((uint128_t)remainder << 64) | a->limb[i];
+    a->limb[i] = (uint64_t)(part / 10);
+    remainder = (uint64_t)(part % 10);
+  }
+}
+
+int bigfixFromString(bigfix_t* r, const char* text)
+{
+  bool negative = *text == '-';
+  if(*text == '-' || *text == '+')
+    text++;
+
+  const char* integer = text;
+  while(isdigit((unsigned char)*text))
+    text++;
+  const char* integer_end = text;
+  const char* fraction = text;
+  const char* fraction_end = text;
+  if(*text == '.')
+  {
+    fraction = ++text;
+    while(isdigit((unsigned char)*text))
+      text++;
+    fraction_end = text;
+  }
+  if(*text != '\0' || (integer == integer_end && fraction == fraction_end))
+    return -1;
+
+  // 0.d1d2...dn = (d1 + (d2 + ... (dn + 0) / 10 ...) / 10) / 10
+  memset(r, 0, sizeof(*r));
+  for(const char* digit = fraction_end; digit > fraction; digit--)
+  {
+    r->limb[0] = digit[-1] - '0';
+    divideBy10(r);
+  }
+  for(const char* digit = integer; digit < integer_end; digit++)
+    r->limb[0] = r->limb[0]*10 + (*digit - '0');
+
+  if(negative)
+    negate(r, BIGFIX_LIMBS);
+  return 0;
+}
+
+void bigfixAdd(bigfix_t* r, const bigfix_t* a, const bigfix_t* b,
+               unsigned limbs)
+{
+  uint64_t carry = 0;
+  for(int i = limbs - 1; i >= 0; i--)
+  {
+    uint128_t sum = (uint128_t)a->limb[i] + b->limb[i] + carry;
+    r->limb[i] = (uint64_t)sum;
+    carry = (uint64_t)(sum >> 64);
+  }
+  clearFrom(r, limbs);
+}
+
+void bigfixSub(bigfix_t* r, const bigfix_t* a, const bigfix_t* b,
+               unsigned limbs)
+{
+  bigfix_t minus = *b;
+  negate(&minus, limbs);
+  bigfixAdd(r, a, &minus, limbs);
+}
+
+void bigfixMul(bigfix_t* r, const bigfix_t* a, const bigfix_t* b,
+               unsigned limbs)
+{
+  bool negative = bigfixNegative(a) != bigfixNegative(b);
+  bigfix_t x = *a, y = *b;
+  if(bigfixNegative(&x))
+    negate(&x, limbs);
+  if(bigfixNegative(&y))
+    negate(&y, limbs);
+
+  // Schoolbook product of the magnitudes, limb i*j lands at position i + j.
+  // Positions past limbs are dropped except for the one feeding carries.
+  uint64_t product[BIGFIX_LIMBS + 1] = {0};
+  for(int i = limbs - 1; i >= 0; i--)
+  {
+    uint64_t carry = 0;
+    int last = (int)limbs - i < (int)limbs - 1 ? (int)limbs - i
+                                               : (int)limbs - 1;
+    for(int j = last; j >= 0; j--)
+    {
+      uint128_t part = (uint128_t)x.limb[i]*y.limb[j] + product[i + j]
+                       + carry;
+      product[i + j] = (uint64_t)part;
+      carry = (uint64_t)(part >> 64);
+    }
+    // nothing has been stored above position i yet
+    if(i > 0)
+      product[i - 1] = carry;
+  }
+
+  memcpy(r->limb, product, limbs * sizeof(uint64_t));
+  clearFrom(r, limbs);
+  if(negative)
+    negate(r, limbs);
+}
@@ -0,0 +1,42 @@
+#ifndef BIGFIX_SW_H
+#define BIGFIX_SW_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+  Multi-limb fixed point for the perturbation reference orbit. A value is a
+  two's complement number of BIGFIX_LIMBS 64-bit limbs: limb[0] is the
+  signed integer part and limb[i] has weight 2^(-64 i). An all-zero value
+  is 0, so zero-initialised views need no setup. Operations take the number
+  of limbs that matter, the rest of the result is cleared; products are
+  truncated, not rounded.
+*/
+
+// 1 integer + 17 fraction limbs: 1088 bits, about 327 decimal places
+#define BIGFIX_LIMBS 18
+
+typedef struct
+{
+  uint64_t limb[BIGFIX_LIMBS];
+} bigfix_t;
+
+// Limbs needed to resolve a pixel spacing of step with some guard bits
+unsigned bigfixLimbsFor(double step);
+
+// Exact for every double with a magnitude below 2^63
+void bigfixFromDouble(bigfix_t* r, double value);
+double bigfixToDouble(const bigfix_t* a);
+
+// Parses [-]digits[.digits], returns -1 if text is not such a number
+int bigfixFromString(bigfix_t* r, const char* text);
+
+bool bigfixNegative(const bigfix_t* a);
+void bigfixAdd(bigfix_t* r, const bigfix_t* a, const bigfix_t* b,
+               unsigned limbs);
+void bigfixSub(bigfix_t* r, const bigfix_t* a, const bigfix_t* b,
+               unsigned limbs);
+void bigfixMul(bigfix_t* r, const bigfix_t* a, const bigfix_t* b,
+               unsigned limbs);
+
+#endif // BIGFIX_SW_H
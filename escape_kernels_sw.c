@@ -0,0 +1,268 @@
+#include <math.h>
+
+#include "render_internal_sw.h"
+#include "interior_sw.h"
+
+/*
+  Scalar kernels of every fractal in every number format, instantiated from
+  escape_line_sw.h. The double and 4.29 Mandelbrot and Julia kernels run
+  the operation sequence of the vector kernels, so they finish the rows
+  those leave over and give the same counts.
+*/
+
+typedef unsigned __int128 uint128_t;
+
+kernel_kind_t kernelKind(const view_t* view)
+{
+  switch(view->fractal)
+  {
+    case FRACTAL_JULIA:
+      return KERNEL_JULIA;
+    case FRACTAL_BURNING_SHIP:
+      return KERNEL_BURNING_SHIP;
+    case FRACTAL_MULTIBROT:
+      return view->power == 4 ? KERNEL_MULTIBROT4 : KERNEL_MULTIBROT3;
+    default:
+      return KERNEL_MANDELBROT;
+  }
+}
+
+// IEEE double
+#define ESCAPE_T double
+#define ESCAPE_MUL(a, b) ((a)*(b))
+#define ESCAPE_TWICE(a) (2*(a))
+#define ESCAPE_ABS(a) fabs(a)
+#define ESCAPE_TWO 2.0
+#define ESCAPE_OFFSET(i, f) ((i)*(f))
+#define ESCAPE_TO_DOUBLE(a) (a)
+#define ESCAPE_FROM_DOUBLE(a) (a)
+#define ESCAPE_RESUME 1
+#define ESCAPE_OUTSIDE(re, im, re2, im2) ((re2) + (im2) > 4)
+#define ESCAPE_CARDIOID(re, im) insideCardioidOrBulb(re, im)
+#define ESCAPE_MIN_RE vp->MinRe
+#define ESCAPE_MAX_IM vp->MaxIm
+#define ESCAPE_FACTOR vp->factor
+#define ESCAPE_K_RE view->kRe
+#define ESCAPE_K_IM view->kIm
+#define ESCAPE_MULTIBROT 1
+#define ESCAPE_PREFIX iterateDouble
+#include "escape_line_sw.h"
+#undef ESCAPE_T
+#undef ESCAPE_MUL
+#undef ESCAPE_TWICE
+#undef ESCAPE_ABS
+#undef ESCAPE_TWO
+#undef ESCAPE_OFFSET
+#undef ESCAPE_TO_DOUBLE
+#undef ESCAPE_FROM_DOUBLE
+#undef ESCAPE_RESUME
+#undef ESCAPE_OUTSIDE
+#undef ESCAPE_CARDIOID
+#undef ESCAPE_MIN_RE
+#undef ESCAPE_MAX_IM
+#undef ESCAPE_FACTOR
+#undef ESCAPE_K_RE
+#undef ESCAPE_K_IM
+#undef ESCAPE_MULTIBROT
+#undef ESCAPE_PREFIX
+
+// IEEE single, coordinates formed in single precision too
+#define ESCAPE_T float
+#define ESCAPE_MUL(a, b) ((a)*(b))
+#define ESCAPE_TWICE(a) (2*(a))
+#define ESCAPE_ABS(a) fabsf(a)
+#define ESCAPE_TWO 2.0f
+#define ESCAPE_OFFSET(i, f) ((float)(i)*(f))
+#define ESCAPE_TO_DOUBLE(a) (double)(a)
+#define ESCAPE_FROM_DOUBLE(a) (float)(a)
+#define ESCAPE_RESUME 1
+#define ESCAPE_OUTSIDE(re, im, re2, im2) ((re2) + (im2) > 4)
+#define ESCAPE_CARDIOID(re, im) insideCardioidOrBulb(re, im)
+#define ESCAPE_MIN_RE vp->sMinRe
+#define ESCAPE_MAX_IM vp->sMaxIm
+#define ESCAPE_FACTOR vp->sFactor
+#define ESCAPE_K_RE vp->skRe
+#define ESCAPE_K_IM vp->skIm
+#define ESCAPE_MULTIBROT 1
+#define ESCAPE_PREFIX iterateFloat
+#include "escape_line_sw.h"
+#undef ESCAPE_T
+#undef ESCAPE_MUL
+#undef ESCAPE_TWICE
+#undef ESCAPE_ABS
+#undef ESCAPE_TWO
+#undef ESCAPE_OFFSET
+#undef ESCAPE_TO_DOUBLE
+#undef ESCAPE_FROM_DOUBLE
+#undef ESCAPE_RESUME
+#undef ESCAPE_OUTSIDE
+#undef ESCAPE_CARDIOID
+#undef ESCAPE_MIN_RE
+#undef ESCAPE_MAX_IM
+#undef ESCAPE_FACTOR
+#undef ESCAPE_K_RE
+#undef ESCAPE_K_IM
+#undef ESCAPE_MULTIBROT
+#undef ESCAPE_PREFIX
+
+// 4.29, the hardware model: pixel offsets and the doubling go through
+// multFixed like on the datapath
+#define ESCAPE_T fixed_point_t
+#define ESCAPE_MUL(a, b) multFixed(a, b)
+#define ESCAPE_TWICE(a) multFixed(floatToFixed(2), a)
+#define ESCAPE_ABS(a) ((a) < 0 ? -(a) : (a))
+#define ESCAPE_TWO floatToFixed(2)
+#define ESCAPE_OFFSET(i, f) multFixed(floatToFixed(i), f)
+#define ESCAPE_TO_DOUBLE(a) fixedToFloat(a)
+#define ESCAPE_FROM_DOUBLE(a) floatToFixed(a)
+#define ESCAPE_RESUME 1
+#define ESCAPE_OUTSIDE(re, im, re2, im2) ((re2) + (im2) > floatToFixed(4))
+#define ESCAPE_CARDIOID(re, im) insideCardioidOrBulbFixed(re, im)
+#define ESCAPE_MIN_RE vp->fMinRe
+#define ESCAPE_MAX_IM vp->fMaxIm
+#define ESCAPE_FACTOR vp->fFactor
+#define ESCAPE_K_RE vp->fkRe
+#define ESCAPE_K_IM vp->fkIm
+#define ESCAPE_MULTIBROT 1
+#define ESCAPE_PREFIX iterateFixed
+#include "escape_line_sw.h"
+#undef ESCAPE_T
+#undef ESCAPE_MUL
+#undef ESCAPE_TWICE
+#undef ESCAPE_ABS
+#undef ESCAPE_TWO
+#undef ESCAPE_OFFSET
+#undef ESCAPE_TO_DOUBLE
+#undef ESCAPE_FROM_DOUBLE
+#undef ESCAPE_RESUME
+#undef ESCAPE_OUTSIDE
+#undef ESCAPE_CARDIOID
+#undef ESCAPE_MIN_RE
+#undef ESCAPE_MAX_IM
+#undef ESCAPE_FACTOR
+#undef ESCAPE_K_RE
+#undef ESCAPE_K_IM
+#undef ESCAPE_MULTIBROT
+#undef ESCAPE_PREFIX
+
+/*
+  4.60 and 4.124. A pixel index times the factor is a plain integer product
+  (multFixed(floatToFixed(i), f) is exactly that) and the escape test never
+  overflows the format: a part above 2 has escaped already, otherwise both
+  squares are at most 4 and their sum fits the unsigned type. Only cycle
+  detection is used for interior points, the cardioid test in double can't
+  tell pixels apart that are this close together. With 3 integer bits left
+  z^3 + c can overflow, so the multibrots stay in 4.29, see
+  viewFixedFormat(). A double can't hold their z, so their pixels are not
+  resumed.
+*/
+#define ESCAPE_WIDE_OUTSIDE(re, im, re2, im2, U, one)                       \
+  ((re) > 2*(one) || (re) < -2*(one) || (im) > 2*(one) || (im) < -2*(one) \
+   || (U)(re2) + (U)(im2) > (U)(4*(one)))
+
+#define ESCAPE_T fixed60_t
+#define ESCAPE_MUL(a, b) multFixed60(a, b)
+#define ESCAPE_TWICE(a) (2*(a))
+#define ESCAPE_ABS(a) ((a) < 0 ? -(a) : (a))
+#define ESCAPE_TWO ((fixed60_t)2 << FIXED60_BITS)
+#define ESCAPE_OFFSET(i, f) ((i)*(f))
+#define ESCAPE_TO_DOUBLE(a) ldexp((double)(a), -FIXED60_BITS)
+#define ESCAPE_RESUME 0
+#define ESCAPE_OUTSIDE(re, im, re2, im2)                                   \
+  ESCAPE_WIDE_OUTSIDE(re, im, re2, im2, uint64_t,                          \
+                      (fixed60_t)1 << FIXED60_BITS)
+#define ESCAPE_CARDIOID(re, im) false
+#define ESCAPE_MIN_RE (fixed60_t)vp->wMinRe
+#define ESCAPE_MAX_IM (fixed60_t)vp->wMaxIm
+#define ESCAPE_FACTOR (fixed60_t)vp->wFactor
+#define ESCAPE_K_RE (fixed60_t)vp->wkRe
+#define ESCAPE_K_IM (fixed60_t)vp->wkIm
+#define ESCAPE_MULTIBROT 0
+#define ESCAPE_PREFIX iterateFixed60
+#include "escape_line_sw.h"
+#undef ESCAPE_T
+#undef ESCAPE_MUL
+#undef ESCAPE_TWICE
+#undef ESCAPE_ABS
+#undef ESCAPE_TWO
+#undef ESCAPE_OFFSET
+#undef ESCAPE_TO_DOUBLE
+#undef ESCAPE_FROM_DOUBLE
+#undef ESCAPE_RESUME
+#undef ESCAPE_OUTSIDE
+#undef ESCAPE_CARDIOID
+#undef ESCAPE_MIN_RE
+#undef ESCAPE_MAX_IM
+#undef ESCAPE_FACTOR
+#undef ESCAPE_K_RE
+#undef ESCAPE_K_IM
+#undef ESCAPE_MULTIBROT
+#undef ESCAPE_PREFIX
+
+#define ESCAPE_T fixed124_t
+#define ESCAPE_MUL(a, b) multFixed124(a, b)
+#define ESCAPE_TWICE(a) (2*(a))
+#define ESCAPE_ABS(a) ((a) < 0 ? -(a) : (a))
+#define ESCAPE_TWO ((fixed124_t)2 << FIXED124_BITS)
+#define ESCAPE_OFFSET(i, f) ((i)*(f))
+#define ESCAPE_TO_DOUBLE(a) ldexp((double)(a), -FIXED124_BITS)
+#define ESCAPE_RESUME 0
+#define ESCAPE_OUTSIDE(re, im, re2, im2)                                   \
+  ESCAPE_WIDE_OUTSIDE(re, im, re2, im2, uint128_t,                         \
+                      (fixed124_t)1 << FIXED124_BITS)
+#define ESCAPE_CARDIOID(re, im) false
+#define ESCAPE_MIN_RE vp->wMinRe
+#define ESCAPE_MAX_IM vp->wMaxIm
+#define ESCAPE_FACTOR vp->wFactor
+#define ESCAPE_K_RE vp->wkRe
+#define ESCAPE_K_IM vp->wkIm
+#define ESCAPE_MULTIBROT 0
+#define ESCAPE_PREFIX iterateFixed124
+#include "escape_line_sw.h"
+#undef ESCAPE_T
+#undef ESCAPE_MUL
+#undef ESCAPE_TWICE
+#undef ESCAPE_ABS
+#undef ESCAPE_TWO
+#undef ESCAPE_OFFSET
+#undef ESCAPE_TO_DOUBLE
+#undef ESCAPE_FROM_DOUBLE
+#undef ESCAPE_RESUME
+#undef ESCAPE_OUTSIDE
+#undef ESCAPE_CARDIOID
+#undef ESCAPE_MIN_RE
+#undef ESCAPE_MAX_IM
+#undef ESCAPE_FACTOR
+#undef ESCAPE_K_RE
+#undef ESCAPE_K_IM
+#undef ESCAPE_MULTIBROT
+#undef ESCAPE_PREFIX
+
+escape_line_fn escapeLine(const view_t* view, const viewport_t* vp)
+{
+  kernel_kind_t kind = kernelKind(view);
+  int constant = view->MaxIterations == ESCAPE_CONSTANT_LIMIT;
+
+  if(view->numeric == NUMERIC_FLOAT)
+    return iterateFloatLines[kind][constant];
+  if(view->numeric != NUMERIC_FIXED)
+    return iterateDoubleLines[kind][constant];
+  if(vp->format == FIXED_4_60)
+    return iterateFixed60Lines[kind][constant];
+  if(vp->format == FIXED_4_124)
+    return iterateFixed124Lines[kind][constant];
+  return iterateFixedLines[kind][constant];
+}
+
+escape_resume_fn escapeResume(const view_t* view, const viewport_t* vp)
+{
+  kernel_kind_t kind = kernelKind(view);
+
+  if(view->numeric == NUMERIC_FLOAT)
+    return iterateFloatResumes[kind];
+  if(view->numeric == NUMERIC_DOUBLE)
+    return iterateDoubleResumes[kind];
+  if(view->numeric == NUMERIC_FIXED && vp->format == FIXED_4_29)
+    return iterateFixedResumes[kind];
+  return NULL;
+}
@@ -0,0 +1,296 @@
+/*
+  Scalar escape-time kernel, included by escape_kernels_sw.c once per
+  number format with these defined:
+
+    ESCAPE_T              signed type of the format
+    ESCAPE_MUL(a, b)      product of two ESCAPE_T values
+    ESCAPE_TWICE(a)       2a
+    ESCAPE_ABS(a)         |a|
+    ESCAPE_TWO            2 in the format
+    ESCAPE_OFFSET(i, f)   i pixels of spacing f, i a long
+    ESCAPE_TO_DOUBLE(a)   a value of the format as a double
+    ESCAPE_RESUME         1 if ESCAPE_FROM_DOUBLE(a) converts a double back
+                          and a z that has not escaped survives the round
+                          trip exactly, which resuming pixels needs
+    ESCAPE_OUTSIDE(re, im, re2, im2)
+                          |z| > 2, given z and the squares of its parts
+    ESCAPE_CARDIOID(re, im)
+                          c in the main cardioid or period-2 bulb, false
+                          where the format can't tell its pixels apart
+    ESCAPE_MIN_RE, ESCAPE_MAX_IM, ESCAPE_FACTOR, ESCAPE_K_RE, ESCAPE_K_IM
+                          corner, step and Julia constant, read from vp
+    ESCAPE_MULTIBROT      0 if z^3 and z^4 don't fit the format
+    ESCAPE_PREFIX         prefix of the names defined
+
+  The loop body is written once and the formula, the cardioid test and the
+  iteration limit are arguments of an always-inline function, so every
+  instance below is compiled with them constant: the per-pixel Julia and
+  fractal checks fold away. The copy for ESCAPE_CONSTANT_LIMIT is unrolled
+  by 4 like the others and only compares against an immediate limit; that
+  measured 3-10% faster for every format at 1024x768, 50 iterations, one
+  thread and -v scalar (min of repeated --repeat 200 runs).
+  ESCAPE_PREFIX##Lines[kind][constant] holds the instances, NULL for the
+  multibrots of formats without them, and ESCAPE_PREFIX##Resumes[kind] the
+  kernels that carry pixels on to a higher limit, for formats with
+  ESCAPE_RESUME.
+*/
+
+#ifndef ESCAPE_LINE_SW_H
+#define ESCAPE_LINE_SW_H
+
+#define ESCAPE_CONCAT_(a, b) a##b
+#define ESCAPE_CONCAT(a, b) ESCAPE_CONCAT_(a, b)
+#define ESCAPE_NAME(name) ESCAPE_CONCAT(ESCAPE_PREFIX, name)
+
+#define ESCAPE_INSTANCE(name, kind, limit)                                   \
+  static void ESCAPE_NAME(name)(const view_t* view, const viewport_t* vp,    \
+                                bool column, unsigned line, unsigned t0,     \
+                                unsigned t1, unsigned stride, unsigned shift,\
+                                uint32_t* out, float* magnitude,             \
+                                escape_state_t* state)                       \
+  {                                                                          \
+    ESCAPE_NAME(Line)(view, vp, column, line, t0, t1, stride, shift, out,    \
+                      magnitude, state, kind, limit);                        \
+  }
+
+#define ESCAPE_RESUME_INSTANCE(name, kind)                                   \
+  static void ESCAPE_NAME(name)(const view_t* view, const viewport_t* vp,    \
+                                unsigned y, const unsigned* xs,              \
+                                unsigned count, uint32_t* out,               \
+                                float* magnitude, escape_state_t* state)     \
+  {                                                                          \
+    ESCAPE_NAME(ResumeLine)(view, vp, y, xs, count, out, magnitude, state,   \
+                            kind);                                           \
+  }
+
+#endif // ESCAPE_LINE_SW_H
+
+// Iterates z from *Z_re + *Z_im i on from count n up to MaxIterations and
+// returns the count where it escaped, or MaxIterations. z is left where
+// it stopped; *cycle is set if the orbit was caught repeating itself.
+static inline __attribute__((always_inline))
+uint32_t ESCAPE_NAME(Orbit)(const viewport_t* vp, kernel_kind_t kind,
+                            ESCAPE_T k_re, ESCAPE_T k_im, ESCAPE_T* z_re,
+                            ESCAPE_T* z_im, uint32_t n,
+                            uint32_t MaxIterations, bool* cycle)
+{
+  ESCAPE_T Z_re = *z_re, Z_im = *z_im;
+  ESCAPE_T saved_re = Z_re, saved_im = Z_im;
+  unsigned period = 0, interval = BRENT_FIRST_INTERVAL;
+
+  // 4 iterations between two looks at the limit
+#pragma GCC unroll 4
+  for(; n < MaxIterations; n++)
+  {
+    // z^3 and z^4 of a larger part would not fit in the format
+    if(kind >= KERNEL_MULTIBROT3
+       && (ESCAPE_ABS(Z_re) > ESCAPE_TWO || ESCAPE_ABS(Z_im) > ESCAPE_TWO))
+      break;
+    ESCAPE_T Z_im2 = ESCAPE_MUL(Z_im, Z_im);
+    ESCAPE_T Z_re2 = ESCAPE_MUL(Z_re, Z_re);
+
+    if(ESCAPE_OUTSIDE(Z_re, Z_im, Z_re2, Z_im2)) // |z| > 2
+      break;
+
+    if(kind == KERNEL_MANDELBROT || kind == KERNEL_JULIA)
+    {
+      // (a + bi)^2 = (a^2 - b^2) + (2ab)i
+      Z_im = ESCAPE_TWICE(ESCAPE_MUL(Z_re, Z_im)) + k_im;
+      Z_re = Z_re2 - Z_im2 + k_re;
+    }
+    else if(kind == KERNEL_BURNING_SHIP)
+    {
+      // (|a| + |b|i)^2
+      Z_im = ESCAPE_TWICE(ESCAPE_MUL(ESCAPE_ABS(Z_re), ESCAPE_ABS(Z_im)))
+             + k_im;
+      Z_re = Z_re2 - Z_im2 + k_re;
+    }
+    else if(kind == KERNEL_MULTIBROT3)
+    {
+      // (a + bi)^3 = a(a^2 - 3b^2) + b(3a^2 - b^2)i
+      ESCAPE_T re = ESCAPE_MUL(Z_re, Z_re2 - 3*Z_im2) + k_re;
+      Z_im = ESCAPE_MUL(Z_im, 3*Z_re2 - Z_im2) + k_im;
+      Z_re = re;
+    }
+    else
+    {
+      // (a + bi)^4 = ((a + bi)^2)^2
+      ESCAPE_T s_re = Z_re2 - Z_im2;
+      ESCAPE_T s_im = ESCAPE_TWICE(ESCAPE_MUL(Z_re, Z_im));
+      Z_im = ESCAPE_TWICE(ESCAPE_MUL(s_re, s_im)) + k_im;
+      Z_re = ESCAPE_MUL(s_re, s_re) - ESCAPE_MUL(s_im, s_im) + k_re;
+    }
+
+    if(vp->interior)
+    {
+      if(Z_re == saved_re && Z_im == saved_im) // periodic orbit
+      {
+        *cycle = true;
+        n = MaxIterations;
+        break;
+      }
+      if(++period == interval)
+      {
+        saved_re = Z_re;
+        saved_im = Z_im;
+        interval *= 2;
+        period = 0;
+      }
+    }
+  }
+  *z_re = Z_re;
+  *z_im = Z_im;
+  return n;
+}
+
+// Writes the outputs of a pixel whose orbit stopped at z after n iterations
+static inline __attribute__((always_inline))
+void ESCAPE_NAME(Store)(ESCAPE_T Z_re, ESCAPE_T Z_im, uint32_t n, bool capped,
+                        uint32_t* out, float* magnitude,
+                        escape_state_t* state)
+{
+  *out = n;
+  if(magnitude != NULL)
+  {
+    // in double, the square of an escaped part can overflow the format
+    double re = ESCAPE_TO_DOUBLE(Z_re), im = ESCAPE_TO_DOUBLE(Z_im);
+    *magnitude = re*re + im*im;
+  }
+#if ESCAPE_RESUME
+  if(state != NULL)
+  {
+    state->re = capped ? ESCAPE_TO_DOUBLE(Z_re) : NAN;
+    state->im = capped ? ESCAPE_TO_DOUBLE(Z_im) : NAN;
+  }
+#endif
+}
+
+static inline __attribute__((always_inline))
+void ESCAPE_NAME(Line)(const view_t* view, const viewport_t* vp, bool column,
+                       unsigned line, unsigned t0, unsigned t1,
+                       unsigned stride, unsigned shift, uint32_t* out,
+                       float* magnitude, escape_state_t* state,
+                       kernel_kind_t kind, uint32_t MaxIterations)
+{
+  ESCAPE_T MinRe = ESCAPE_MIN_RE, MaxIm = ESCAPE_MAX_IM;
+  ESCAPE_T factor = ESCAPE_FACTOR;
+  bool julia = kind == KERNEL_JULIA;
+
+  // positions in the panned image, see view_t
+  long line_at = (long)line + (column ? view->panX : view->panY);
+  int32_t offset = (column ? view->panY : view->panX) + shift;
+  ESCAPE_T line_re = MinRe + ESCAPE_OFFSET(line_at, factor);
+  ESCAPE_T line_im = MaxIm - ESCAPE_OFFSET(line_at, factor);
+
+  for(unsigned t = t0; t < t1; t++)
+  {
+    long t_at = (long)t*stride + offset;
+    ESCAPE_T c_re = column ? line_re : MinRe + ESCAPE_OFFSET(t_at, factor);
+    ESCAPE_T c_im = column ? MaxIm - ESCAPE_OFFSET(t_at, factor) : line_im;
+    ESCAPE_T k_re = julia ? ESCAPE_K_RE : c_re;
+    ESCAPE_T k_im = julia ? ESCAPE_K_IM : c_im;
+    float* pixel_magnitude = magnitude != NULL ? magnitude + (t - t0) : NULL;
+    escape_state_t* pixel_state = state != NULL ? state + (t - t0) : NULL;
+
+    if(kind == KERNEL_MANDELBROT && vp->interior
+       && ESCAPE_CARDIOID(c_re, c_im))
+    {
+      ESCAPE_NAME(Store)(0, 0, MaxIterations, false, out + (t - t0),
+                         pixel_magnitude, pixel_state);
+      continue;
+    }
+
+    ESCAPE_T Z_re = c_re, Z_im = c_im; // Set Z = c
+    bool cycle = false;
+    uint32_t n = ESCAPE_NAME(Orbit)(vp, kind, k_re, k_im, &Z_re, &Z_im, 0,
+                                    MaxIterations, &cycle);
+    ESCAPE_NAME(Store)(Z_re, Z_im, n, n == MaxIterations && !cycle,
+                       out + (t - t0), pixel_magnitude, pixel_state);
+  } // for
+}
+
+#if ESCAPE_RESUME
+// Pixels xs[0..count) of row y carried on from state[x] and out[x]
+// iterations to the view's MaxIterations, outputs in place
+static inline __attribute__((always_inline))
+void ESCAPE_NAME(ResumeLine)(const view_t* view, const viewport_t* vp,
+                             unsigned y, const unsigned* xs, unsigned count,
+                             uint32_t* out, float* magnitude,
+                             escape_state_t* state, kernel_kind_t kind)
+{
+  ESCAPE_T MinRe = ESCAPE_MIN_RE, MaxIm = ESCAPE_MAX_IM;
+  ESCAPE_T factor = ESCAPE_FACTOR;
+  bool julia = kind == KERNEL_JULIA;
+  uint32_t MaxIterations = view->MaxIterations;
+
+  // as in the line kernel, row by row without stride or shift
+  long y_at = (long)y + view->panY;
+  ESCAPE_T c_im = MaxIm - ESCAPE_OFFSET(y_at, factor);
+
+  for(unsigned i = 0; i < count; i++)
+  {
+    unsigned x = xs[i];
+    long x_at = (long)x + view->panX;
+    ESCAPE_T c_re = MinRe + ESCAPE_OFFSET(x_at, factor);
+    ESCAPE_T k_re = julia ? ESCAPE_K_RE : c_re;
+    ESCAPE_T k_im = julia ? ESCAPE_K_IM : c_im;
+
+    ESCAPE_T Z_re = ESCAPE_FROM_DOUBLE(state[x].re);
+    ESCAPE_T Z_im = ESCAPE_FROM_DOUBLE(state[x].im);
+    bool cycle = false;
+    uint32_t n = ESCAPE_NAME(Orbit)(vp, kind, k_re, k_im, &Z_re, &Z_im,
+                                    out[x], MaxIterations, &cycle);
+    ESCAPE_NAME(Store)(Z_re, Z_im, n, n == MaxIterations && !cycle,
+                       out + x, magnitude != NULL ? magnitude + x : NULL,
+                       state + x);
+  } // for
+}
+#endif
+
+ESCAPE_INSTANCE(Mandelbrot, KERNEL_MANDELBROT, view->MaxIterations)
+ESCAPE_INSTANCE(MandelbrotConstant, KERNEL_MANDELBROT, ESCAPE_CONSTANT_LIMIT)
+ESCAPE_INSTANCE(Julia, KERNEL_JULIA, view->MaxIterations)
+ESCAPE_INSTANCE(JuliaConstant, KERNEL_JULIA, ESCAPE_CONSTANT_LIMIT)
+ESCAPE_INSTANCE(BurningShip, KERNEL_BURNING_SHIP, view->MaxIterations)
+ESCAPE_INSTANCE(BurningShipConstant, KERNEL_BURNING_SHIP,
+                ESCAPE_CONSTANT_LIMIT)
+#if ESCAPE_MULTIBROT
+ESCAPE_INSTANCE(Multibrot3, KERNEL_MULTIBROT3, view->MaxIterations)
+ESCAPE_INSTANCE(Multibrot3Constant, KERNEL_MULTIBROT3, ESCAPE_CONSTANT_LIMIT)
+ESCAPE_INSTANCE(Multibrot4, KERNEL_MULTIBROT4, view->MaxIterations)
+ESCAPE_INSTANCE(Multibrot4Constant, KERNEL_MULTIBROT4, ESCAPE_CONSTANT_LIMIT)
+#endif
+
+static const escape_line_fn ESCAPE_NAME(Lines)[KERNEL_KINDS][2] = {
+  [KERNEL_MANDELBROT] = {ESCAPE_NAME(Mandelbrot),
+                         ESCAPE_NAME(MandelbrotConstant)},
+  [KERNEL_JULIA] = {ESCAPE_NAME(Julia), ESCAPE_NAME(JuliaConstant)},
+  [KERNEL_BURNING_SHIP] = {ESCAPE_NAME(BurningShip),
+                           ESCAPE_NAME(BurningShipConstant)},
+#if ESCAPE_MULTIBROT
+  [KERNEL_MULTIBROT3] = {ESCAPE_NAME(Multibrot3),
+                         ESCAPE_NAME(Multibrot3Constant)},
+  [KERNEL_MULTIBROT4] = {ESCAPE_NAME(Multibrot4),
+                         ESCAPE_NAME(Multibrot4Constant)},
+#endif
+};
+
+#if ESCAPE_RESUME
+ESCAPE_RESUME_INSTANCE(ResumeMandelbrot, KERNEL_MANDELBROT)
+ESCAPE_RESUME_INSTANCE(ResumeJulia, KERNEL_JULIA)
+ESCAPE_RESUME_INSTANCE(ResumeBurningShip, KERNEL_BURNING_SHIP)
+#if ESCAPE_MULTIBROT
+ESCAPE_RESUME_INSTANCE(ResumeMultibrot3, KERNEL_MULTIBROT3)
+ESCAPE_RESUME_INSTANCE(ResumeMultibrot4, KERNEL_MULTIBROT4)
+#endif
+
+static const escape_resume_fn ESCAPE_NAME(Resumes)[KERNEL_KINDS] = {
+  [KERNEL_MANDELBROT] = ESCAPE_NAME(ResumeMandelbrot),
+  [KERNEL_JULIA] = ESCAPE_NAME(ResumeJulia),
+  [KERNEL_BURNING_SHIP] = ESCAPE_NAME(ResumeBurningShip),
+#if ESCAPE_MULTIBROT
+  [KERNEL_MULTIBROT3] = ESCAPE_NAME(ResumeMultibrot3),
+  [KERNEL_MULTIBROT4] = ESCAPE_NAME(ResumeMultibrot4),
+#endif
+};
+#endif
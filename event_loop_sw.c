@@ -0,0 +1,23 @@
+#include <errno.h>
+#include <poll.h>
+
+#include "event_loop_sw.h"
+
+bool waitForDisplay(Display* dis, int wake_fd, int timeout_ms)
+{
+  // XPending flushes the output buffer and picks up events Xlib has
+  // already read off the socket, which poll() would not see
+  if(XPending(dis) > 0)
+    return true;
+
+  struct pollfd fds[2] = {
+    {.fd = ConnectionNumber(dis), .events = POLLIN},
+    {.fd = wake_fd, .events = POLLIN}   // ignored by poll when negative
+  };
+  int ready;
+  do
+    ready = poll(fds, 2, timeout_ms);
+  while(ready < 0 && errno == EINTR);
+
+  return ready > 0;
+}
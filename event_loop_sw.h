@@ -0,0 +1,18 @@
+#ifndef EVENT_LOOP_SW_H
+#define EVENT_LOOP_SW_H
+
+#include <stdbool.h>
+#include <X11/Xlib.h>
+
+/*
+  Helpers for redraw-on-demand viewer loops: instead of polling for events
+  between back-to-back frames, a viewer sleeps on the X connection until
+  there is something to do.
+*/
+
+// Flushes pending requests and blocks until an event can be read, wake_fd
+// becomes readable (-1 for none) or timeout_ms milliseconds pass (-1 waits
+// forever). Returns false on timeout.
+bool waitForDisplay(Display* dis, int wake_fd, int timeout_ms);
+
+#endif // EVENT_LOOP_SW_H
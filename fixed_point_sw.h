@@ -0,0 +1,112 @@
+#ifndef FIXED_POINT_SW_H
+#define FIXED_POINT_SW_H
+
+#include <stdint.h>
+
+/*
+  Fixed-point formats of the integer kernels. All of them have 4 integer
+  bits (sign included), so every value the iteration keeps fits below 8:
+
+    4.29   in a 64-bit long, the modelled hardware datapath. Products use
+           the full 64 bits and wrap around like the hardware (-fwrapv).
+    4.60   in 64 bits, products are formed in __int128.
+    4.124  in __int128, products are built from four 64x64-bit partial
+           products.
+
+  Wider formats cost more per iteration, so the render picks the narrowest
+  one whose fraction still resolves the pixel step, see fixedFormatFor().
+*/
+
+typedef enum
+{
+  FIXED_4_29,
+  FIXED_4_60,
+  FIXED_4_124,
+  FIXED_AUTO      // narrowest format for the step
+} fixed_format_t;
+
+// Fraction bits a format must have beyond those of the pixel step, so that
+// neighbouring pixels stay apart after the orbit's rounding
+#define FIXED_GUARD_BITS 8
+
+// Fixed-point Format: 4.29 (32-bit)
+typedef long fixed_point_t;
+
+#define NORM_BITS 29
+
+#define NORM_FACT ((fixed_point_t)1 << NORM_BITS)
+
+static inline double fixedToFloat(fixed_point_t input)
+{
+  return (double)input / NORM_FACT;
+}
+
+static inline fixed_point_t floatToFixed(double input)
+{
+  return (fixed_point_t)(input * NORM_FACT);
+}
+
+// multiply fixed point integers
+static inline fixed_point_t multFixed(fixed_point_t a, fixed_point_t b)
+{
+  return (a * b) >> NORM_BITS;
+}
+
+// Fixed-point Format: 4.60 (64-bit)
+typedef int64_t fixed60_t;
+
+#define FIXED60_BITS 60
+
+static inline fixed60_t floatToFixed60(double input)
+{
+  return (fixed60_t)(input * ((int64_t)1 << FIXED60_BITS));
+}
+
+static inline fixed60_t multFixed60(fixed60_t a, fixed60_t b)
+{
+  return (fixed60_t)(((__int128)a * b) >> FIXED60_BITS);
+}
+
+// Fixed-point Format: 4.124 (128-bit)
+typedef __int128 fixed124_t;
+
+#define FIXED124_BITS 124
+
+static inline fixed124_t floatToFixed124(double input)
+{
+  // scaled in two steps, 2^124 is out of a long's range
+  return (fixed124_t)(input * ((int64_t)1 << 62) * ((int64_t)1 << 62));
+}
+
+// Truncates towards zero where the narrower formats round down
+static inline fixed124_t multFixed124(fixed124_t a, fixed124_t b)
+{
+  typedef unsigned __int128 uint128_t;
+  uint128_t x = a < 0 ? -(uint128_t)a : (uint128_t)a;
+  uint128_t y = b < 0 ? -(uint128_t)b : (uint128_t)b;
+  uint64_t x1 = x >> 64, x0 = x, y1 = y >> 64, y0 = y;
+
+  // 256-bit magnitude high:low from the four 64x64-bit products
+  uint128_t p00 = (uint128_t)x0*y0, p01 = (uint128_t)x0*y1;
+  uint128_t p10 = (uint128_t)x1*y0, p11 = (uint128_t)x1*y1;
+  uint128_t middle = (p00 >> 64) + (uint64_t)p01 + (uint64_t)p10;
+  uint128_t high = p11 + (p01 >> 64) + (p10 >> 64) + (middle >> 64);
+  uint128_t low = (middle << 64) | (uint64_t)p00;
+
+  uint128_t product = (high << (128 - FIXED124_BITS))
+                      | (low >> FIXED124_BITS);
+  return (a < 0) != (b < 0) ? -(fixed124_t)product : (fixed124_t)product;
+}
+
+// Narrowest format with FIXED_GUARD_BITS fraction bits below the step
+static inline fixed_format_t fixedFormatFor(double step)
+{
+  double guard = (double)((int64_t)1 << FIXED_GUARD_BITS);
+  if(step * NORM_FACT >= guard)
+    return FIXED_4_29;
+  if(step * ((int64_t)1 << FIXED60_BITS) >= guard)
+    return FIXED_4_60;
+  return FIXED_4_124;
+}
+
+#endif // FIXED_POINT_SW_H
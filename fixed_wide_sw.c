@@ -0,0 +1,56 @@
+#include "render_internal_sw.h"
+
+/*
+  Viewport setup of the 4.60 and 4.124 fixed-point formats, whose kernels
+  are in escape_kernels_sw.c. The view centre is the double one plus the
+  deep remainder of view_t, so these formats can be given centres with more
+  digits than a double holds.
+*/
+
+typedef unsigned __int128 uint128_t;
+
+// The remainders are far below 1, so their integer limb is 0 or -1 and
+// both formats take it whole
+static fixed124_t deepToFixed(const bigfix_t* deep, unsigned bits)
+{
+  uint128_t fraction = ((uint128_t)deep->limb[1] << 64) | deep->limb[2];
+  fixed124_t integer = (fixed124_t)(int64_t)deep->limb[0];
+  return (integer << bits) + (fixed124_t)(fraction >> (128 - bits));
+}
+
+void setupWideViewport(const view_t* view, viewport_t* vp)
+{
+  uint32_t ImageWidth = view->width;
+  uint32_t ImageHeight = view->height;
+
+  if(vp->format == FIXED_4_60)
+  {
+    fixed60_t factor = floatToFixed60(view->step);
+    fixed60_t cRe = floatToFixed60(view->cRe)
+                    + deepToFixed(&view->deepRe, FIXED60_BITS);
+    fixed60_t cIm = floatToFixed60(view->cIm)
+                    + deepToFixed(&view->deepIm, FIXED60_BITS);
+
+    vp->wFactor = factor;
+    vp->wMinRe = cRe - factor*(ImageWidth/2);
+    fixed60_t MinIm = cIm - factor*(ImageHeight/2);
+    vp->wMaxIm = MinIm + factor*ImageHeight;
+    vp->wkRe = floatToFixed60(view->kRe);
+    vp->wkIm = floatToFixed60(view->kIm);
+  }
+  else
+  {
+    fixed124_t factor = floatToFixed124(view->step);
+    fixed124_t cRe = floatToFixed124(view->cRe)
+                     + deepToFixed(&view->deepRe, FIXED124_BITS);
+    fixed124_t cIm = floatToFixed124(view->cIm)
+                     + deepToFixed(&view->deepIm, FIXED124_BITS);
+
+    vp->wFactor = factor;
+    vp->wMinRe = cRe - factor*(ImageWidth/2);
+    fixed124_t MinIm = cIm - factor*(ImageHeight/2);
+    vp->wMaxIm = MinIm + factor*ImageHeight;
+    vp->wkRe = floatToFixed124(view->kRe);
+    vp->wkIm = floatToFixed124(view->kIm);
+  }
+}
@@ -0,0 +1,162 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "frame_stats_sw.h"
+
+struct frame_stats_log
+{
+  FILE* file;
+  bool csv;
+};
+
+double statsClock()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Tiles served from and computed past the cache and the store so far. A
+// cache miss goes on to the store when there is one, so its misses are the
+// tiles that were iterated.
+static void tileCounts(unsigned long* hits, unsigned long* misses)
+{
+  tile_cache_stats_t cache = renderTileCacheStats();
+  tile_store_stats_t store = renderTileStoreStats();
+  *hits = cache.hits + store.hits;
+  *misses = store.hits + store.misses > 0 ? store.misses : cache.misses;
+}
+
+void startFrameProbe(frame_probe_t* probe)
+{
+  memset(probe->busy, 0, sizeof(probe->busy));
+  renderThreadBusy(probe->busy, FRAME_STATS_THREADS);
+  tileCounts(&probe->hits, &probe->misses);
+  probe->start = statsClock();
+}
+
+void finishFrameProbe(const frame_probe_t* probe, frame_stats_t* stats)
+{
+  stats->compute_ms = (statsClock() - probe->start) * 1e3;
+
+  double busy[FRAME_STATS_THREADS] = {0};
+  unsigned threads = renderThreadBusy(busy, FRAME_STATS_THREADS);
+  stats->threads = threads < FRAME_STATS_THREADS ? threads
+                                                 : FRAME_STATS_THREADS;
+  for(unsigned i = 0; i < stats->threads; i++)
+    stats->busy_ms[i] = (busy[i] - probe->busy[i]) * 1e3;
+
+  unsigned long hits, misses;
+  tileCounts(&hits, &misses);
+  stats->cache_hits = hits - probe->hits;
+  stats->cache_misses = misses - probe->misses;
+}
+
+void countFrameIterations(frame_stats_t* stats, const view_t* view,
+                          const uint32_t* iterations)
+{
+  size_t count = (size_t)view->width * view->height;
+  uint64_t total = 0;
+  size_t inside = 0;
+  for(size_t i = 0; i < count; i++)
+  {
+    uint32_t n = iterations[i];
+    bool in = isInsideCount(n, view->MaxIterations);
+    total += in ? view->MaxIterations : n;
+    inside += in;
+  }
+
+  stats->iterations = total;
+  stats->inside = inside;
+  stats->escaped = count - inside;
+  stats->mean_iterations = count > 0 ? (double)total / count : 0;
+  stats->max_iterations = view->MaxIterations;
+}
+
+void formatFrameStats(const frame_stats_t* stats, char* text, size_t size)
+{
+  double least = 0, most = 0;
+  for(unsigned i = 0; i < stats->threads; i++)
+  {
+    if(i == 0 || stats->busy_ms[i] < least)
+      least = stats->busy_ms[i];
+    if(stats->busy_ms[i] > most)
+      most = stats->busy_ms[i];
+  }
+  size_t pixels = stats->escaped + stats->inside;
+  char refined[32] = "";
+  if(stats->refined > 0)
+    snprintf(refined, sizeof(refined), ", %.1f%% aa",
+             100.0 * stats->refined / pixels);
+
+  snprintf(text, size, "%.1f/%.1f/%.1f ms, %.1f/%u it/px, %.0f%% esc%s, "
+           "busy %.1f-%.1f ms x%u, cache %lu/%lu",
+           stats->compute_ms, stats->colour_ms, stats->present_ms,
+           stats->mean_iterations, stats->max_iterations,
+           pixels > 0 ? 100.0 * stats->escaped / pixels : 0, refined, least,
+           most, stats->threads, stats->cache_hits,
+           stats->cache_hits + stats->cache_misses);
+}
+
+frame_stats_log_t* openFrameStatsLog(const char* path)
+{
+  frame_stats_log_t* log = calloc(1, sizeof(*log));
+  if(log == NULL)
+    return NULL;
+  log->file = fopen(path, "w");
+  if(log->file == NULL)
+  {
+    free(log);
+    return NULL;
+  }
+
+  size_t length = strlen(path);
+  log->csv = length >= 4 && strcmp(path + length - 4, ".csv") == 0;
+  if(log->csv)
+    fprintf(log->file, "frame,compute_ms,colour_ms,present_ms,iterations,"
+            "escaped,inside,mean_iterations,max_iterations,reused,refined,"
+            "cache_hits,cache_misses,threads,busy_ms\n");
+  return log;
+}
+
+void logFrameStats(frame_stats_log_t* log, const frame_stats_t* stats)
+{
+  if(log->csv)
+    fprintf(log->file, "%lu,%.3f,%.3f,%.3f,%llu,%zu,%zu,%.3f,%u,%zu,%zu,"
+            "%lu,%lu,%u,", stats->frame, stats->compute_ms,
+            stats->colour_ms, stats->present_ms,
+            (unsigned long long)stats->iterations, stats->escaped,
+            stats->inside, stats->mean_iterations, stats->max_iterations,
+            stats->reused, stats->refined, stats->cache_hits,
+            stats->cache_misses, stats->threads);
+  else
+    fprintf(log->file, "{\"frame\": %lu, \"compute_ms\": %.3f, "
+            "\"colour_ms\": %.3f, \"present_ms\": %.3f, \"iterations\": %llu, "
+            "\"escaped\": %zu, \"inside\": %zu, \"mean_iterations\": %.3f, "
+            "\"max_iterations\": %u, \"reused\": %zu, \"refined\": %zu, "
+            "\"cache_hits\": %lu, \"cache_misses\": %lu, \"threads\": %u, "
+            "\"busy_ms\": [", stats->frame, stats->compute_ms,
+            stats->colour_ms, stats->present_ms,
+            (unsigned long long)stats->iterations, stats->escaped,
+            stats->inside, stats->mean_iterations, stats->max_iterations,
+            stats->reused, stats->refined, stats->cache_hits,
+            stats->cache_misses, stats->threads);
+
+  // per-thread times in one CSV field, separated by semicolons
+  for(unsigned i = 0; i < stats->threads; i++)
+    fprintf(log->file, "%s%.3f", i == 0 ? "" : log->csv ? ";" : ", ",
+            stats->busy_ms[i]);
+  fprintf(log->file, log->csv ? "\n" : "]}\n");
+  fflush(log->file);
+}
+
+void closeFrameStatsLog(frame_stats_log_t* log)
+{
+  if(log == NULL)
+    return;
+  fclose(log->file);
+  free(log);
+}
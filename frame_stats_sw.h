@@ -0,0 +1,76 @@
+#ifndef FRAME_STATS_SW_H
+#define FRAME_STATS_SW_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "render_sw.h"
+
+/*
+  Per-frame instrumentation: where the time of a frame went and how much
+  work it was. A probe taken before the counts are computed is diffed
+  against the render core's cumulative counters (thread busy time, tile
+  cache and store hits) afterwards; the counts themselves give the
+  iteration totals. Statistics can be logged one line per frame, as CSV or
+  JSON lines.
+*/
+
+// Per-thread busy times are kept for this many render threads
+#define FRAME_STATS_THREADS 64
+
+typedef struct
+{
+  unsigned long frame;      // sequence number, set by the caller
+  double compute_ms;        // iteration counts, wall time
+  double colour_ms;         // antialiasing included
+  double present_ms;        // left to the viewer
+  uint64_t iterations;      // sum of the counts, inside pixels at the limit
+  size_t escaped;
+  size_t inside;
+  double mean_iterations;   // per pixel
+  uint32_t max_iterations;  // the frame's limit
+  size_t reused;            // pixels carried over from the previous frame
+  size_t refined;           // pixels supersampled by antialiasing
+  unsigned long cache_hits; // tiles served by the tile cache or store
+  unsigned long cache_misses;
+  unsigned threads;
+  double busy_ms[FRAME_STATS_THREADS];  // per render thread
+} frame_stats_t;
+
+typedef struct
+{
+  double start;
+  double busy[FRAME_STATS_THREADS];
+  unsigned long hits;
+  unsigned long misses;
+} frame_probe_t;
+
+typedef struct frame_stats_log frame_stats_log_t;
+
+// Monotonic clock in seconds for timing frame stages
+double statsClock();
+
+void startFrameProbe(frame_probe_t* probe);
+
+// Fills compute_ms, threads, busy_ms and the cache counts of stats with
+// what happened since the probe started
+void finishFrameProbe(const frame_probe_t* probe, frame_stats_t* stats);
+
+// Fills the iteration totals of stats from a frame's counts
+void countFrameIterations(frame_stats_t* stats, const view_t* view,
+                          const uint32_t* iterations);
+
+// One status-bar line: compute/colour/present ms, iterations per pixel
+// and the limit, escaped share, antialiased share if any, the range of
+// thread busy times and cache hits/lookups
+void formatFrameStats(const frame_stats_t* stats, char* text, size_t size);
+
+// Opens a log at path, CSV with a header line if it ends in .csv, JSON
+// lines otherwise. Returns NULL if the file can't be created.
+frame_stats_log_t* openFrameStatsLog(const char* path);
+
+void logFrameStats(frame_stats_log_t* log, const frame_stats_t* stats);
+
+void closeFrameStatsLog(frame_stats_log_t* log);
+
+#endif // FRAME_STATS_SW_H
@@ -0,0 +1,174 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+#include "framebuffer_sw.h"
+
+static bool shm_attach_failed;
+
+static int shmErrorHandler(Display* dis, XErrorEvent* error)
+{
+  shm_attach_failed = true;
+  return 0;
+}
+
+static int hostByteOrder()
+{
+  uint32_t probe = 1;
+  return (*(uint8_t*)&probe == 1) ? LSBFirst : MSBFirst;
+}
+
+// Tries to back the framebuffer by a MIT-SHM segment; leaves fb untouched
+// and returns false if the extension is missing or the attach fails (e.g.
+// on a remote display)
+static bool createShmImage(framebuffer_t* fb, Visual* visual, int depth)
+{
+  if(!XShmQueryExtension(fb->dis))
+    return false;
+
+  XImage* image = XShmCreateImage(fb->dis, visual, depth, ZPixmap, NULL,
+                                  &fb->shminfo, fb->width, fb->height);
+  if(image == NULL)
+    return false;
+
+  if(image->bits_per_pixel != 32)
+  {
+    XDestroyImage(image);
+    return false;
+  }
+
+  fb->shminfo.shmid = shmget(IPC_PRIVATE, image->bytes_per_line * image->height,
+                             IPC_CREAT | 0600);
+  if(fb->shminfo.shmid < 0)
+  {
+    XDestroyImage(image);
+    return false;
+  }
+
+  fb->shminfo.shmaddr = image->data = shmat(fb->shminfo.shmid, NULL, 0);
+  fb->shminfo.readOnly = False;
+  if(fb->shminfo.shmaddr == (char*)-1)
+  {
+    shmctl(fb->shminfo.shmid, IPC_RMID, NULL);
+    XDestroyImage(image);
+    return false;
+  }
+
+  // the attach error (if any) is only reported once the server has seen it
+  shm_attach_failed = false;
+  XSync(fb->dis, False);
+  int (*old_handler)(Display*, XErrorEvent*) = XSetErrorHandler(shmErrorHandler);
+  XShmAttach(fb->dis, &fb->shminfo);
+  XSync(fb->dis, False);
+  XSetErrorHandler(old_handler);
+
+  // segment is freed automatically once both sides have detached
+  shmctl(fb->shminfo.shmid, IPC_RMID, NULL);
+
+  if(shm_attach_failed)
+  {
+    shmdt(fb->shminfo.shmaddr);
+    image->data = NULL;
+    XDestroyImage(image);
+    return false;
+  }
+
+  fb->image = image;
+  fb->shm = true;
+  return true;
+}
+
+static bool createPlainImage(framebuffer_t* fb, Visual* visual, int depth)
+{
+  // zeroed like a fresh shm segment, so the window starts out black
+  char* data = calloc((size_t)fb->width * fb->height, sizeof(uint32_t));
+  if(data == NULL)
+    return false;
+
+  XImage* image = XCreateImage(fb->dis, visual, depth, ZPixmap, 0, data,
+                               fb->width, fb->height, 32, 0);
+  if(image == NULL || image->bits_per_pixel != 32
+     || image->bytes_per_line != fb->width * sizeof(uint32_t))
+  {
+    if(image != NULL)
+      XDestroyImage(image); // frees data as well
+    else
+      free(data);
+    return false;
+  }
+
+  // pixels are written as host-order uint32_t, let Xlib swap if needed
+  image->byte_order = hostByteOrder();
+
+  fb->image = image;
+  fb->shm = false;
+  return true;
+}
+
+int createFramebuffer(framebuffer_t* fb, Display* dis,
+                      uint32_t width, uint32_t height)
+{
+  memset(fb, 0, sizeof(*fb));
+  fb->dis = dis;
+  fb->width = width;
+  fb->height = height;
+
+  int screen = DefaultScreen(dis);
+  Visual* visual = DefaultVisual(dis, screen);
+  int depth = DefaultDepth(dis, screen);
+
+  // colours are packed as 0x00RRGGBB, which is what 24/32-bit TrueColor uses
+  if(depth < 24 || visual->red_mask != 0xFF0000
+     || visual->green_mask != 0x00FF00 || visual->blue_mask != 0x0000FF)
+  {
+    fprintf(stderr, "Unsupported visual (depth %d), need 24-bit TrueColor.\n",
+            depth);
+    return -1;
+  }
+
+  if(!createShmImage(fb, visual, depth) && !createPlainImage(fb, visual, depth))
+  {
+    fprintf(stderr, "Couldn't create framebuffer image.\n");
+    return -1;
+  }
+
+  fb->pixels = (uint32_t*)fb->image->data;
+  return 0;
+}
+
+void presentFramebuffer(framebuffer_t* fb, Drawable d, GC gc, int x, int y)
+{
+  if(fb->shm)
+  {
+    XShmPutImage(fb->dis, d, gc, fb->image, 0, 0, x, y,
+                 fb->width, fb->height, False);
+    // the server reads the segment asynchronously, wait until it is done
+    // before the next frame overwrites the pixels
+    XSync(fb->dis, False);
+  }
+  else
+  {
+    XPutImage(fb->dis, d, gc, fb->image, 0, 0, x, y, fb->width, fb->height);
+    XFlush(fb->dis);
+  }
+}
+
+void destroyFramebuffer(framebuffer_t* fb)
+{
+  if(fb->image == NULL)
+    return;
+
+  if(fb->shm)
+  {
+    XShmDetach(fb->dis, &fb->shminfo);
+    XSync(fb->dis, False);
+    shmdt(fb->shminfo.shmaddr);
+    fb->image->data = NULL;
+  }
+  XDestroyImage(fb->image);
+
+  fb->image = NULL;
+  fb->pixels = NULL;
+}
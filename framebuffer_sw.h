@@ -0,0 +1,36 @@
+#ifndef FRAMEBUFFER_SW_H
+#define FRAMEBUFFER_SW_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+
+/*
+  In-memory 0x00RRGGBB framebuffer that the kernels write into and the
+  window layer presents with a single XPutImage per frame. When the X server
+  supports MIT-SHM the pixels live in a shared memory segment and are
+  presented with XShmPutImage (no copy through the X protocol).
+*/
+typedef struct
+{
+  Display* dis;
+  XImage* image;
+  XShmSegmentInfo shminfo;
+  bool shm;           // true if presented through MIT-SHM
+  uint32_t width;
+  uint32_t height;
+  uint32_t* pixels;   // width * height pixels, row-major
+} framebuffer_t;
+
+// Returns 0 on success, -1 if the default visual can't be used
+int createFramebuffer(framebuffer_t* fb, Display* dis,
+                      uint32_t width, uint32_t height);
+
+// Copies the whole framebuffer to (x, y) in the drawable
+void presentFramebuffer(framebuffer_t* fb, Drawable d, GC gc, int x, int y);
+
+void destroyFramebuffer(framebuffer_t* fb);
+
+#endif // FRAMEBUFFER_SW_H
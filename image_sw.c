@@ -0,0 +1,133 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <zlib.h>
+
+#include "image_sw.h"
+
+static void packRGB(const uint32_t* pixels, uint32_t width, uint8_t* rgb)
+{
+  for(uint32_t x = 0; x < width; x++)
+  {
+    rgb[3*x + 0] = (pixels[x] >> 16) & 0xFF;
+    rgb[3*x + 1] = (pixels[x] >> 8) & 0xFF;
+    rgb[3*x + 2] = pixels[x] & 0xFF;
+  }
+}
+
+int writePPM(const char* path, const uint32_t* pixels,
+             uint32_t width, uint32_t height)
+{
+  FILE* file = fopen(path, "wb");
+  if(file == NULL)
+    return -1;
+
+  uint8_t* rgb = malloc((size_t)width * 3);
+  if(rgb == NULL)
+  {
+    fclose(file);
+    return -1;
+  }
+
+  int status = fprintf(file, "P6\n%u %u\n255\n", width, height) > 0 ? 0 : -1;
+  for(uint32_t y = 0; y < height && status == 0; y++)
+  {
+    packRGB(pixels + (size_t)y*width, width, rgb);
+    if(fwrite(rgb, 3, width, file) != width)
+      status = -1;
+  }
+
+  free(rgb);
+  if(fclose(file) != 0)
+    status = -1;
+  return status;
+}
+
+static void put32(uint8_t* p, uint32_t value)
+{
+  p[0] = value >> 24;
+  p[1] = value >> 16;
+  p[2] = value >> 8;
+  p[3] = value;
+}
+
+static int writeChunk(FILE* file, const char* type,
+                      const uint8_t* data, uint32_t length)
+{
+  uint8_t header[8];
+  put32(header, length);
+  memcpy(header + 4, type, 4);
+
+  uLong crc = crc32(0, (const Bytef*)type, 4);
+  if(length > 0)
+    crc = crc32(crc, data, length);
+
+  uint8_t trailer[4];
+  put32(trailer, crc);
+
+  if(fwrite(header, 1, 8, file) != 8
+     || (length > 0 && fwrite(data, 1, length, file) != length)
+     || fwrite(trailer, 1, 4, file) != 4)
+    return -1;
+  return 0;
+}
+
+int writePNG(const char* path, const uint32_t* pixels,
+             uint32_t width, uint32_t height)
+{
+  // every scanline is prefixed with its filter type (0 = none)
+  size_t stride = (size_t)width * 3 + 1;
+  size_t raw_size = stride * height;
+  uint8_t* raw = malloc(raw_size);
+  uLongf packed_size = compressBound(raw_size);
+  uint8_t* packed = malloc(packed_size);
+  if(raw == NULL || packed == NULL)
+  {
+    free(raw);
+    free(packed);
+    return -1;
+  }
+
+  for(uint32_t y = 0; y < height; y++)
+  {
+    raw[y*stride] = 0;
+    packRGB(pixels + (size_t)y*width, width, raw + y*stride + 1);
+  }
+
+  int status = -1;
+  FILE* file = NULL;
+  if(compress2(packed, &packed_size, raw, raw_size, Z_DEFAULT_COMPRESSION)
+     == Z_OK && (file = fopen(path, "wb")) != NULL)
+  {
+    static const uint8_t signature[8] = {137, 'P', 'N', 'G', 13, 10, 26, 10};
+    uint8_t ihdr[13];
+    put32(ihdr, width);
+    put32(ihdr + 4, height);
+    ihdr[8] = 8;    // bit depth
+    ihdr[9] = 2;    // colour type RGB
+    ihdr[10] = 0;   // deflate
+    ihdr[11] = 0;   // adaptive filtering
+    ihdr[12] = 0;   // no interlace
+
+    status = (fwrite(signature, 1, 8, file) == 8
+              && writeChunk(file, "IHDR", ihdr, 13) == 0
+              && writeChunk(file, "IDAT", packed, packed_size) == 0
+              && writeChunk(file, "IEND", NULL, 0) == 0) ? 0 : -1;
+    if(fclose(file) != 0)
+      status = -1;
+  }
+
+  free(raw);
+  free(packed);
+  return status;
+}
+
+int writeImage(const char* path, const uint32_t* pixels,
+               uint32_t width, uint32_t height)
+{
+  const char* extension = strrchr(path, '.');
+  if(extension != NULL && strcasecmp(extension, ".png") == 0)
+    return writePNG(path, pixels, width, height);
+  return writePPM(path, pixels, width, height);
+}
@@ -0,0 +1,18 @@
+#ifndef IMAGE_SW_H
+#define IMAGE_SW_H
+
+#include <stdint.h>
+
+// Writes 0x00RRGGBB pixels as binary PPM (P6), returns 0 on success
+int writePPM(const char* path, const uint32_t* pixels,
+             uint32_t width, uint32_t height);
+
+// Writes 0x00RRGGBB pixels as 8-bit RGB PNG, returns 0 on success
+int writePNG(const char* path, const uint32_t* pixels,
+             uint32_t width, uint32_t height);
+
+// Picks PNG or PPM from the file extension (PPM if unknown)
+int writeImage(const char* path, const uint32_t* pixels,
+               uint32_t width, uint32_t height);
+
+#endif // IMAGE_SW_H
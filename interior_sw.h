@@ -0,0 +1,41 @@
+#ifndef INTERIOR_SW_H
+#define INTERIOR_SW_H
+
+#include <stdbool.h>
+
+#include "fixed_point_sw.h"
+
+/*
+  Interior detection for the Mandelbrot set. Points in the main cardioid or
+  the period-2 bulb never escape, so they can be marked inside without
+  iterating. Orbits that settle on an attracting cycle are caught with
+  Brent's algorithm: z is saved at iterations 1, 2, 4, 8, ... and an exact
+  repeat of the saved value means the orbit is periodic and can never
+  escape. Both give the same result as running to MaxIterations.
+*/
+
+// First Brent checkpoint; the interval doubles after every checkpoint
+#define BRENT_FIRST_INTERVAL 1
+
+static inline bool insideCardioidOrBulb(double c_re, double c_im)
+{
+  double c_im2 = c_im*c_im;
+
+  // main cardioid: q(q + (x - 1/4)) <= y^2 / 4, q = (x - 1/4)^2 + y^2
+  double x_q = c_re - 0.25;
+  double q = x_q*x_q + c_im2;
+  if(q*(q + x_q) <= 0.25*c_im2)
+    return true;
+
+  // period-2 bulb: (x + 1)^2 + y^2 <= 1/16
+  double x_b = c_re + 1.0;
+  return x_b*x_b + c_im2 <= 0.0625;
+}
+
+static inline bool insideCardioidOrBulbFixed(fixed_point_t c_re,
+                                             fixed_point_t c_im)
+{
+  return insideCardioidOrBulb(fixedToFloat(c_re), fixedToFloat(c_im));
+}
+
+#endif // INTERIOR_SW_H
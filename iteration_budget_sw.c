@@ -0,0 +1,79 @@
+#include <math.h>
+#include <stddef.h>
+
+#include "iteration_budget_sw.h"
+
+void defaultIterationBudget(iteration_budget_t* budget)
+{
+  budget->min_iterations = BUDGET_MIN_ITERATIONS;
+  budget->max_iterations = BUDGET_MAX_ITERATIONS;
+  budget->raise_share = BUDGET_RAISE_SHARE;
+}
+
+uint32_t zoomIterations(const iteration_budget_t* budget, const view_t* view)
+{
+  double zoom = zoomToStep(1, view->height) / view->step;
+  double octaves = zoom > 1 ? log2(zoom) : 0;
+  double limit = budget->min_iterations
+                 + octaves * BUDGET_ITERATIONS_PER_OCTAVE;
+  return limit < budget->max_iterations ? (uint32_t)limit
+                                        : budget->max_iterations;
+}
+
+uint32_t adaptIterations(const iteration_budget_t* budget,
+                         const view_t* view, const uint32_t* iterations)
+{
+  uint32_t MaxIterations = view->MaxIterations;
+  size_t count = (size_t)view->width * view->height;
+
+  // pixels escaping in the top half of the limit, and in the quarter below
+  // it, which would be the top half after halving
+  size_t top = 0, below = 0;
+  uint32_t half = MaxIterations / 2, quarter = MaxIterations / 4;
+  for(size_t i = 0; i < count; i++)
+  {
+    uint32_t n = iterations[i];
+    top += n >= half && n < MaxIterations;
+    below += n >= quarter && n < half;
+  }
+
+  uint32_t floor = zoomIterations(budget, view);
+  uint32_t limit = MaxIterations;
+  if(top > budget->raise_share * count)
+    limit = MaxIterations <= budget->max_iterations / 2
+            ? 2*MaxIterations : budget->max_iterations;
+  // half the raise share, so that the halved limit is not raised again
+  else if(below < budget->raise_share / 2 * count)
+    limit = half;
+
+  if(limit < floor)
+    limit = floor;
+  return limit < budget->max_iterations ? limit : budget->max_iterations;
+}
+
+unsigned computeIterationsAdaptive(const iteration_budget_t* budget,
+                                   view_t* view, uint32_t* iterations,
+                                   float* magnitudes, escape_state_t* states)
+{
+  view->MaxIterations = zoomIterations(budget, view);
+  computeRegionResumable(view, iterations, magnitudes, states, 0, 0,
+                         view->width, view->height);
+
+  unsigned rounds = 1;
+  uint32_t limit;
+  while(!renderCancelled()
+        && (limit = adaptIterations(budget, view, iterations))
+           != view->MaxIterations)
+  {
+    uint32_t from = view->MaxIterations;
+    view->MaxIterations = limit;
+    if(resumableView(view))
+      resumeIterations(view, from, iterations, magnitudes, states, 0, 0,
+                       view->width, view->height);
+    else
+      computeRegionResumable(view, iterations, magnitudes, states, 0, 0,
+                             view->width, view->height);
+    rounds++;
+  } // while
+  return rounds;
+}
@@ -0,0 +1,58 @@
+#ifndef ITERATION_BUDGET_SW_H
+#define ITERATION_BUDGET_SW_H
+
+#include <stdint.h>
+
+#include "render_sw.h"
+
+/*
+  Adaptive iteration limit. A view starts from a limit that grows with the
+  log of its zoom, since deeper views need longer orbits to resolve the
+  boundary. Then the escape counts of the last frame decide: pixels that
+  escape in the top half of the limit are the boundary pixels it barely
+  resolves, and when more than a small share of the frame does, doubling
+  it would turn about as many capped pixels into escaped ones, so it is
+  doubled. It is halved once halving wouldn't leave that many pixels in
+  the new top half. Iterations thus go where they change the image: a
+  shallow view with a big interior keeps a low limit, a deep one is raised
+  until its filaments stop filling in.
+*/
+
+// Limits the budget stays within
+#define BUDGET_MIN_ITERATIONS 32
+#define BUDGET_MAX_ITERATIONS (1u << 20)
+// Iterations added to the start limit per doubling of the zoom
+#define BUDGET_ITERATIONS_PER_OCTAVE 24
+// Share of the frame escaping in the top half of the limit that raises it
+#define BUDGET_RAISE_SHARE 0.002
+
+typedef struct
+{
+  uint32_t min_iterations;
+  uint32_t max_iterations;
+  double raise_share;
+} iteration_budget_t;
+
+void defaultIterationBudget(iteration_budget_t* budget);
+
+// Limit to start a view from: min_iterations at zoom 1 (see zoomToStep) and
+// BUDGET_ITERATIONS_PER_OCTAVE more per doubling of the zoom, at most
+// max_iterations
+uint32_t zoomIterations(const iteration_budget_t* budget, const view_t* view);
+
+// Limit for the next frame of view after its counts came out as
+// iterations: twice, half or the same as view->MaxIterations, never below
+// zoomIterations() nor above max_iterations
+uint32_t adaptIterations(const iteration_budget_t* budget,
+                         const view_t* view, const uint32_t* iterations);
+
+// Computes view (counts, |z|^2 unless magnitudes is NULL and the pixels'
+// escape states) starting at zoomIterations() and doubling the limit until
+// adaptIterations() settles, resuming the capped pixels each time when the
+// view is resumable. Sets view->MaxIterations to the final limit and
+// returns the number of rounds.
+unsigned computeIterationsAdaptive(const iteration_budget_t* budget,
+                                   view_t* view, uint32_t* iterations,
+                                   float* magnitudes, escape_state_t* states);
+
+#endif // ITERATION_BUDGET_SW_H
@@ -0,0 +1,172 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "iteration_frame_sw.h"
+
+int createIterationFrame(iteration_frame_t* frame, uint32_t width,
+                         uint32_t height)
+{
+  memset(frame, 0, sizeof(*frame));
+  frame->iterations = malloc((size_t)width * height * sizeof(uint32_t));
+  frame->states = malloc((size_t)width * height * sizeof(escape_state_t));
+  if(frame->iterations == NULL || frame->states == NULL)
+  {
+    destroyIterationFrame(frame);
+    return -1;
+  }
+
+  frame->view.width = width;
+  frame->view.height = height;
+  return 0;
+}
+
+// True if both views map pixel (x + panX, y + panY) to the same point,
+// whatever their MaxIterations
+static bool samePlane(const view_t* a, const view_t* b)
+{
+  return a->fractal == b->fractal && a->numeric == b->numeric
+         && a->width == b->width && a->height == b->height
+         && a->cRe == b->cRe && a->cIm == b->cIm && a->step == b->step
+         && a->kRe == b->kRe && a->kIm == b->kIm && a->power == b->power
+         && memcmp(&a->deepRe, &b->deepRe, sizeof(bigfix_t)) == 0
+         && memcmp(&a->deepIm, &b->deepIm, sizeof(bigfix_t)) == 0;
+}
+
+// Moves the pixels of a buffer of size-byte elements so that new pixel
+// (x, y) gets old pixel (x + dx, y + dy)
+static void scroll(void* buffer, size_t size, uint32_t width,
+                   uint32_t height, long dx, long dy)
+{
+  char* pixels = buffer;
+  size_t kept = width - labs(dx);
+  unsigned dst_x = dx < 0 ? -dx : 0;
+  unsigned src_x = dx > 0 ? dx : 0;
+
+  // walk away from the rows being overwritten
+  for(unsigned i = 0; i < height - labs(dy); i++)
+  {
+    unsigned y = dy >= 0 ? i : height - 1 - i;
+    char* dst = pixels + (size_t)y*width*size;
+    const char* src = pixels + (size_t)(y + dy)*width*size;
+    memmove(dst + dst_x*size, src + src_x*size, kept*size);
+  }
+}
+
+int updateIterationFrame(iteration_frame_t* frame, const view_t* view)
+{
+  uint32_t width = view->width;
+  uint32_t height = view->height;
+
+  if(width != frame->view.width || height != frame->view.height)
+  {
+    size_t count = (size_t)width * height;
+    bool smooth = frame->magnitudes != NULL;
+    free(frame->iterations);
+    free(frame->magnitudes);
+    free(frame->states);
+    frame->iterations = malloc(count * sizeof(uint32_t));
+    frame->magnitudes = smooth ? malloc(count * sizeof(float)) : NULL;
+    frame->states = malloc(count * sizeof(escape_state_t));
+    frame->valid = false;
+    if(frame->iterations == NULL || (smooth && frame->magnitudes == NULL)
+       || frame->states == NULL)
+      return -1;
+  }
+
+  render_mode_t mode = renderMode();
+  long dx = (long)view->panX - frame->view.panX;
+  long dy = (long)view->panY - frame->view.panY;
+  frame->reused = 0;
+  frame->resumed = 0;
+  uint32_t* iterations = frame->iterations;
+  float* magnitudes = frame->magnitudes;
+  escape_state_t* states = frame->states;
+  uint32_t from = frame->view.MaxIterations;
+  // pixels started from the series only agree between frames that skip
+  // the same number of iterations, and the skip moves with the pan
+  unsigned series_skip = viewSeriesSkip(view);
+
+  if(!frame->valid || frame->mode != mode
+     || !samePlane(&frame->view, view) || series_skip != frame->series_skip
+     || (from != view->MaxIterations && !resumableView(view))
+     || labs(dx) >= width || labs(dy) >= height)
+  {
+    computeRegionResumable(view, iterations, magnitudes, states, 0, 0,
+                           width, height);
+  }
+  else
+  {
+    frame->reused = (size_t)(width - labs(dx)) * (height - labs(dy));
+    if(dx != 0 || dy != 0)
+    {
+      scroll(iterations, sizeof(uint32_t), width, height, dx, dy);
+      scroll(states, sizeof(escape_state_t), width, height, dx, dy);
+    }
+    if(magnitudes != NULL && (dx != 0 || dy != 0))
+      scroll(magnitudes, sizeof(float), width, height, dx, dy);
+
+    // the kept pixels go on to the new limit before the exposed ones are
+    // computed at it
+    unsigned keep_x0 = dx < 0 ? -dx : 0;
+    unsigned keep_x1 = dx > 0 ? width - dx : width;
+    unsigned keep_y0 = dy < 0 ? -dy : 0;
+    unsigned keep_y1 = dy > 0 ? height - dy : height;
+    if(from != view->MaxIterations)
+    {
+      resumeIterations(view, from, iterations, magnitudes, states, keep_x0,
+                       keep_y0, keep_x1, keep_y1);
+      frame->resumed = renderResumedPixels();
+    }
+
+    // exposed rows over the full width, then exposed columns beside the
+    // rows that were kept
+    if(dy > 0)
+      computeRegionResumable(view, iterations, magnitudes, states, 0,
+                             keep_y1, width, height);
+    else if(dy < 0)
+      computeRegionResumable(view, iterations, magnitudes, states, 0, 0,
+                             width, keep_y0);
+
+    if(dx > 0)
+      computeRegionResumable(view, iterations, magnitudes, states,
+                             width - dx, keep_y0, width, keep_y1);
+    else if(dx < 0)
+      computeRegionResumable(view, iterations, magnitudes, states, 0,
+                             keep_y0, -dx, keep_y1);
+  }
+
+  frame->view = *view;
+  frame->mode = mode;
+  frame->series_skip = series_skip;
+  // skipped tiles hold stale counts, so a cancelled frame can't be reused
+  frame->valid = !renderCancelled();
+  return frame->valid ? 0 : 1;
+}
+
+int setIterationFrameSmooth(iteration_frame_t* frame, bool smooth)
+{
+  if(smooth == (frame->magnitudes != NULL))
+    return 0;
+  if(!smooth)
+  {
+    free(frame->magnitudes);
+    frame->magnitudes = NULL;
+    return 0;
+  }
+
+  frame->magnitudes = malloc((size_t)frame->view.width * frame->view.height
+                             * sizeof(float));
+  frame->valid = false;
+  return frame->magnitudes != NULL ? 0 : -1;
+}
+
+void destroyIterationFrame(iteration_frame_t* frame)
+{
+  free(frame->iterations);
+  free(frame->magnitudes);
+  free(frame->states);
+  frame->iterations = NULL;
+  frame->magnitudes = NULL;
+  frame->states = NULL;
+  frame->valid = false;
+}
@@ -0,0 +1,52 @@
+#ifndef ITERATION_FRAME_SW_H
+#define ITERATION_FRAME_SW_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "render_sw.h"
+
+/*
+  Iteration counts kept between frames. When the next view only differs
+  from the previous one by a whole-pixel pan (view_t panX/panY), the
+  overlapping pixels are scrolled in place and only the newly exposed
+  strips are iterated. A new MaxIterations is applied to the kept counts
+  too: every pixel's escape state is kept alongside its count, so raising
+  the limit only iterates the pixels that hit the old one, on from where
+  they stopped (see resumeIterations()). A perturbation view with the
+  series approximation on is only reused while the pan leaves its series
+  skip unchanged, so kept pixels match a full render bit for bit. Any
+  other change recomputes the whole frame. For smooth colouring the |z|^2
+  of every pixel is kept as well.
+*/
+typedef struct
+{
+  view_t view;          // view held in iterations, if valid
+  render_mode_t mode;   // render mode it was computed with
+  unsigned series_skip; // series approximation skip it was computed with
+  bool valid;
+  uint32_t* iterations; // view.width * view.height counts, row-major
+  float* magnitudes;    // their |z|^2, NULL unless smooth colouring is on
+  escape_state_t* states; // where their orbits stopped
+  size_t reused;        // pixels scrolled instead of computed last update
+  size_t resumed;       // kept pixels iterated further for a new limit
+} iteration_frame_t;
+
+// Returns 0 on success, -1 if the buffers can't be allocated
+int createIterationFrame(iteration_frame_t* frame, uint32_t width,
+                         uint32_t height);
+
+// Brings the buffer up to date with the view. Returns 0 when done, 1 if the
+// render was cancelled (see setRenderCancelFlag) and -1 on allocation
+// failure; in both cases the frame is left invalid.
+int updateIterationFrame(iteration_frame_t* frame, const view_t* view);
+
+// Starts or stops keeping |z|^2. Starting invalidates the frame, whose
+// pixels have none yet. Returns -1 if the buffer can't be allocated, the
+// frame then keeps counts only.
+int setIterationFrameSmooth(iteration_frame_t* frame, bool smooth);
+
+void destroyIterationFrame(iteration_frame_t* frame);
+
+#endif // ITERATION_FRAME_SW_H
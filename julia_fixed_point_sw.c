@@ -1,21 +1,10 @@
-#include "mandelbrot_sw.h"
-
-// Fixed-point Format: 4.29 (32-bit)
-typedef long fixed_point_t;
-
-#define NORM_BITS 29
-
-#define NORM_FACT ((fixed_point_t)1 << NORM_BITS)
+#include <math.h>
 
-// Converts 4.29 to double format
-#define fixedToFloat(input) ((input + ((fixed_point_t)1 << NORM_BITS-1)) \
-                              >> NORM_BITS)
-
-// Converts double to 4.29 format
-#define floatToFixed(input) (fixed_point_t)(input * (NORM_FACT))
-
-// multiply fixed point integers
-#define multFixed(a,b) ((a * b) >> NORM_BITS)
+#include "mandelbrot_sw.h"
+#include "framebuffer_sw.h"
+#include "render_sw.h"
+#include "render_thread_sw.h"
+#include "event_loop_sw.h"
 
 Display* createDisplay()
 {
@@ -107,12 +96,6 @@ int buildColor(int red, int green, int blue)
         (((int)(blue)%256)));
 } 
 
-void drawPixel(int x, int y, int color)
-{
-  XSetForeground(dis, gc, color);
-  XDrawPoint(dis, win, gc, x, y);
-}
-
 void closeDisplay()
 {
   XFreeGC(dis, gc);
@@ -121,70 +104,6 @@ void closeDisplay()
   exit(1);
 }
 
-int julia(uint32_t ImageWidth, uint32_t ImageHeight, 
-               uint32_t MaxIterations, fixed_point_t cRe, fixed_point_t cIm,  
-               fixed_point_t zoom, fixed_point_t kRe, fixed_point_t kIm)
-{
-  fixed_point_t Re_factor = zoom; //floatToFixed((double)0.01 / zoom);
-  fixed_point_t Im_factor = zoom; //floatToFixed((double)0.01 / zoom);
-  
-  fixed_point_t MinRe = cRe - multFixed(Re_factor, 
-                                            floatToFixed(ImageWidth/2));
-  fixed_point_t MinIm = cIm - multFixed(Im_factor, 
-                                            floatToFixed(ImageHeight/2));
-
-  fixed_point_t MaxRe = MinRe + multFixed(Re_factor, 
-                                              floatToFixed(ImageWidth));
-  fixed_point_t MaxIm = MinIm + multFixed(Im_factor, 
-                                              floatToFixed(ImageHeight));
-
-  uint32_t colour_unit = (uint32_t)((1 << 24) / (MaxIterations));
-
-  for(unsigned int y = 0; y < ImageHeight; y++)
-  {
-    fixed_point_t c_im = MaxIm - multFixed(floatToFixed(y), Im_factor);
-    for(unsigned int x = 0; x < ImageWidth; x++)
-    {
-      fixed_point_t c_re = MinRe + multFixed(floatToFixed(x), Re_factor);
-
-      // Calculate whether c belongs to the Mandelbrot set or
-      // not and draw a pixel at coordinates (x,y) accordingly
-      fixed_point_t Z_re = c_re, Z_im = c_im; // Set Z = c
-      bool isInside = true;
-      unsigned n = 0;
-      
-      for(n = 0; n < MaxIterations; n++)
-      {
-        fixed_point_t Z_im2 = multFixed(Z_im, Z_im);
-        fixed_point_t Z_re2 = multFixed(Z_re, Z_re);
-        
-        if(Z_re2 + Z_im2 > floatToFixed(4)) // |z| > 2
-        {
-          isInside = false;
-          break;
-        }
-        /*
-          N.B. Z^2 = (a + bi)^2 = (a^2 - b^2) + (2ab)i
-        */
-        
-        Z_im = multFixed(floatToFixed(2), multFixed(Z_re, Z_im)) 
-                + kIm;
-        Z_re = Z_re2 - Z_im2 + kRe;
-      }
-      
-      if(isInside) 
-      { 
-        drawPixel(x, y, buildColor(0, 0, 0));
-      } // if
-      else
-      {
-        drawPixel(x, y, colour_unit * n); 
-        //drawPixel(x, y, buildColor(((n*10)%255), ((n*10)%255), ((50-n)*20)%255));    
-      }
-    } // for
-  } // for
-} // mandelbrot()
-
 void main()
 {
   ImageWidth = 1000;
@@ -205,16 +124,71 @@ void main()
   {
     printf("created window\n");
     
+    framebuffer_t fb;
+    if(createFramebuffer(&fb, dis, ImageWidth, ImageHeight) == -1)
+      closeDisplay();
+    
+    view_t view = {
+      .fractal = FRACTAL_JULIA,
+      .numeric = NUMERIC_FIXED,
+      .width = ImageWidth,
+      .height = ImageHeight,
+      .MaxIterations = MaxIterations,
+      .kRe = kRe,
+      .kIm = kIm
+    };
+    // frames are computed in the background, so key presses are handled
+    // while a frame renders
+    render_thread_t* renderer = createRenderThread(ImageWidth, ImageHeight);
+    if(renderer == NULL)
+      closeDisplay();
+    view_t shown = view;    // view of the frame on screen
+    
+    // the iteration limit follows the zoom and the escape counts until
+    // 'i', 'I' or 'l' fix it
+    iteration_budget_t budget;
+    defaultIterationBudget(&budget);
+    bool adaptive = true;
+    setRenderIterationBudget(renderer, &budget);
+    
+    unsigned antialias = 0;   // samples per side on edge pixels, 0 for off
+    
+    // 'p' cycles plain colouring and the built-in palettes; the palette
+    // $MANDELBROT_PALETTE names (built in or a file) is used from the start
+    palette_t palette;
+    int palette_index = -1;   // built-in palette shown, -1 for none
+    const char* palette_spec = getenv("MANDELBROT_PALETTE");
+    if(palette_spec != NULL && *palette_spec != '\0')
+    {
+      if(choosePalette(&palette, palette_spec) == 0)
+        setRenderPalette(renderer, &palette);
+      else
+        fprintf(stderr, "%s: no such palette or not a palette file\n",
+                palette_spec);
+    }
+    
     XEvent event;    /* the XEvent declaration !!! */
     KeySym key;    /* a dealie-bob to handle KeyPress Events */  
     char text[255];    /* a char buffer for KeyPress Events */
     
     bool quit = false;
     bool zoom_on = false;
+    bool dirty = true;      // view changed since the last frame
+    bool exposed = false;   // window needs the last frame presented again
     while (!quit) 
     {
-      if(XCheckWindowEvent(dis, win, KeyPressMask, &event))
+      // sleep until there is input or a finished frame
+      if(!dirty && !exposed)
+        waitForDisplay(dis, renderThreadFd(renderer), -1);
+      
+      // handle everything that has arrived, so that a burst of key
+      // presses is rendered as one frame
+      while(XPending(dis) > 0)
       {
+        XNextEvent(dis, &event);
+        if(event.type == Expose && event.xexpose.count == 0)
+          exposed = true;
+        
         if(event.type == KeyPress
            && XLookupString(&event.xkey, text, 255, &key, 0) == 1) 
         {
@@ -224,6 +198,9 @@ void main()
           if (text[0]=='q') 
             quit = true;
             
+          // pans snap to whole pixels so the last frame can be scrolled
+          long shift_pixels = lround(0.1 / (zoomToStep(zoom, ImageHeight)));
+
           switch(text[0])
           {
             // quit
@@ -234,59 +211,142 @@ void main()
             case 'z': 
               zoom_on = !zoom_on;
               break;
+            // cycle brute force / Mariani-Silver / progressive
+            case 'm': 
+              setRenderMode(renderMode() == RENDER_BRUTE_FORCE
+                            ? RENDER_MARIANI_SILVER
+                            : renderMode() == RENDER_MARIANI_SILVER
+                            ? RENDER_PROGRESSIVE : RENDER_BRUTE_FORCE);
+              break;
+            // cycle plain colouring and the smooth palettes, a frame is
+            // recoloured without iterating it again
+            case 'p':
+              palette_index++;
+              if(paletteName(palette_index) == NULL)
+                palette_index = -1;
+              else
+                generatePalette(&palette, paletteName(palette_index));
+              setRenderPalette(renderer, palette_index >= 0 ? &palette
+                                                            : NULL);
+              break;
+            // double / halve the iteration limit, starting from the one on
+            // screen if it was adapting; pixels that hit the old limit
+            // carry on from where they stopped rather than starting over
+            case 'i':
+            case 'I':
+              if(adaptive)
+              {
+                adaptive = false;
+                view.MaxIterations = shown.MaxIterations;
+                setRenderIterationBudget(renderer, NULL);
+              }
+              // the vector kernels keep counts in 32-bit lanes
+              if(text[0] == 'i'
+                 && view.MaxIterations <= BUDGET_MAX_ITERATIONS / 2)
+                view.MaxIterations *= 2;
+              else if(text[0] == 'I' && view.MaxIterations > 1)
+                view.MaxIterations /= 2;
+              break;
+            // adapt the iteration limit, or keep the one on screen
+            case 'l':
+              adaptive = !adaptive;
+              view.MaxIterations = shown.MaxIterations;
+              setRenderIterationBudget(renderer, adaptive ? &budget : NULL);
+              break;
+            // cycle antialiasing off / 2x2 / 4x4
+            case 'x':
+              antialias = antialias == 0 ? 2 : antialias == 2 ? 4 : 0;
+              setRenderAntialias(renderer, antialias);
+              break;
             // reset
             case 'r': 
               zoom = 1;
               zoom_on = false;
+              view.MaxIterations = MaxIterations;
+              adaptive = true;
+              setRenderIterationBudget(renderer, &budget);
               
               cRe = -1.25;
               cIm = -0.18;
+              view.panX = 0;
+              view.panY = 0;
               break;
             // Move left, right, up and down  
             case 'a':
-              cRe -= 0.1;
+              view.panX -= shift_pixels;
               break;
             case 'd':
-              cRe += 0.1;
+              view.panX += shift_pixels;
               break;
             case 'w':
-              cIm += 0.1;
+              view.panY -= shift_pixels;
               break;
             case 's': 
-              cIm -= 0.1;
+              view.panY += shift_pixels;
               break;
               
             default:
-              break;
+              continue; // not a command, nothing to redraw
           } // switch
+          dirty = true;
         } // if key press
-      } // if
-      
-      // continue drawing otherwise
-      julia(ImageWidth, ImageHeight, MaxIterations, 
-                 floatToFixed(cRe), floatToFixed(cIm), 
-                 floatToFixed((double)0.01 / ((ImageHeight/500.0)*zoom)),
-                 floatToFixed(kRe), floatToFixed(kIm));
+      } // while events
       
-      // clear old string
-      for(int i = ImageHeight; i < ImageHeight + text_height; i++)
-      	for(int j = 0; j < ImageWidth; j++)
-			      drawPixel(j, i, buildColor(0, 0, 255));
-      
-      char* status = (char*)malloc(100 * sizeof(char));
-      sprintf(status, "Software Mandelbrot; Zoom: %d;  cRe: %lf; cIm: %lf",
-              zoom, cRe, cIm);
-      
-      XSetForeground(dis, gc, buildColor(255, 0, 0));
+      if(dirty)
+      {
+        view.cRe = cRe;
+        view.cIm = cIm;
+        view.step = zoomToStep(zoom, ImageHeight);
+        requestRender(renderer, &view);
+        dirty = false;
+      }
       
-      XDrawString(dis, win, gc, 0, ImageHeight + text_height - 2, 
-                  status, strlen(status));
+      bool complete;
+      if(takeFrame(renderer, fb.pixels, &shown, &complete))
+      {
+        exposed = true;
+        
+        // auto zoom asks for the next frame once one is on screen, not
+        // just a progressive preview of it
+        if(zoom_on && complete)
+        {
+          // the pan is counted in pixels of the step just rendered
+          recentreView(&view);
+          cRe = view.cRe;
+          cIm = view.cIm;
+          zoom++;
+          dirty = true;
+        }
+      }
       
-      if(zoom_on)
-        zoom++;
+      if(exposed)
+      {
+        presentFramebuffer(&fb, win, gc, 0, 0);
+        
+        // clear old string
+        XSetForeground(dis, gc, buildColor(0, 0, 255));
+        XFillRectangle(dis, win, gc, 0, ImageHeight, ImageWidth, text_height);
+        
+        // zoom, like the centre, of the frame on screen: auto zoom has
+        // already moved zoom on to the next one
+        char status[100];
+        snprintf(status, sizeof(status),
+                 "Software Mandelbrot; Zoom: %ld;  cRe: %lf; cIm: %lf",
+                 lround(stepToZoom(shown.step, shown.height)),
+                 shown.cRe + shown.panX * shown.step,
+                 shown.cIm - shown.panY * shown.step);
+        
+        XSetForeground(dis, gc, buildColor(255, 0, 0));
+        
+        XDrawString(dis, win, gc, 0, ImageHeight + text_height - 2, 
+                    status, strlen(status));
+        exposed = false;
+      }
       
     } // while
     
+    destroyRenderThread(renderer);
+    destroyFramebuffer(&fb);
     closeDisplay();
   } // if
   else
@@ -0,0 +1,765 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <immintrin.h>
+
+#include "kernel_simd_sw.h"
+#include "interior_sw.h"
+
+// Fused multiply-add would round differently from the scalar loop
+#pragma GCC optimize ("fp-contract=off")
+
+static const char* const simd_names[] = {"scalar", "avx2", "avx512"};
+
+int parseSimdLevel(const char* name)
+{
+  for(int level = SIMD_SCALAR; level <= SIMD_AVX512; level++)
+    if(strcmp(name, simd_names[level]) == 0)
+      return level;
+  return -1;
+}
+
+const char* simdLevelName(simd_level_t level)
+{
+  return simd_names[level];
+}
+
+simd_level_t detectSimdLevel()
+{
+  simd_level_t level = SIMD_SCALAR;
+
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq"))
+    level = SIMD_AVX512;
+  else if(__builtin_cpu_supports("avx2"))
+    level = SIMD_AVX2;
+
+  const char* env = getenv("MANDELBROT_SIMD");
+  int requested = env != NULL ? parseSimdLevel(env) : -1;
+  if(requested >= 0 && requested < (int)level)
+    level = requested;
+
+  return level;
+}
+
+// Same operation sequence as insideCardioidOrBulb(), all-ones lanes inside
+__attribute__((target("avx2")))
+static inline __m256d insideCardioidOrBulbAVX2(__m256d c_re, __m256d c_im)
+{
+  __m256d c_im2 = _mm256_mul_pd(c_im, c_im);
+
+  __m256d x_q = _mm256_sub_pd(c_re, _mm256_set1_pd(0.25));
+  __m256d q = _mm256_add_pd(_mm256_mul_pd(x_q, x_q), c_im2);
+  __m256d cardioid = _mm256_cmp_pd(
+    _mm256_mul_pd(q, _mm256_add_pd(q, x_q)),
+    _mm256_mul_pd(_mm256_set1_pd(0.25), c_im2), _CMP_LE_OQ);
+
+  __m256d x_b = _mm256_add_pd(c_re, _mm256_set1_pd(1.0));
+  __m256d bulb = _mm256_cmp_pd(_mm256_add_pd(_mm256_mul_pd(x_b, x_b), c_im2),
+                               _mm256_set1_pd(0.0625), _CMP_LE_OQ);
+  return _mm256_or_pd(cardioid, bulb);
+}
+
+// z of the lanes in the bit mask capped, NaN for the others, interleaved
+// into state as the kernels' state output
+static inline void storeState(const double* re, const double* im,
+                              unsigned capped, unsigned lanes, double* state)
+{
+  for(unsigned i = 0; i < lanes; i++)
+  {
+    bool kept = (capped >> i) & 1;
+    state[2*i] = kept ? re[i] : NAN;
+    state[2*i + 1] = kept ? im[i] : NAN;
+  }
+}
+
+// The kernels below are written once with the |z|^2 output and the
+// pixels to resume as arguments, and inlined into a copy for every use, so
+// plain counts pay for neither. Lanes still active when the loop ends ran
+// to MaxIterations, so their z is the state to carry on from.
+
+__attribute__((target("avx2"), always_inline))
+static inline void rowDoubleAVX2(const double_row_t* row,
+                                 const double_resume_t* resume, unsigned x0,
+                                 unsigned x1, uint32_t* out, float* magnitude,
+                                 double* state)
+{
+  const __m256d four = _mm256_set1_pd(4.0);
+  const __m256d two = _mm256_set1_pd(2.0);
+  const __m256d one = _mm256_set1_pd(1.0);
+  const __m256d max = _mm256_set1_pd(row->MaxIterations);
+  const __m256d MinRe = _mm256_set1_pd(row->MinRe);
+  const __m256d factor = _mm256_set1_pd(row->factor);
+  const __m256d MaxIm = _mm256_set1_pd(row->MaxIm);
+
+  unsigned x = x0;
+  for(; x < x1; x += 4)
+  {
+    // lanes past x1 start inactive and are not stored
+    unsigned valid = x1 - x < 4 ? x1 - x : 4;
+    __m256i lanes = _mm256_cmpgt_epi64(_mm256_set1_epi64x(valid),
+                                       _mm256_set_epi64x(3, 2, 1, 0));
+    long s = row->stride, p = (long)x*s + row->offset;
+    __m256d xs = _mm256_set_pd(p + 3*s, p + 2*s, p + s, p);
+    __m256d c_re, c_im, Z_re, Z_im;
+    if(resume != NULL)
+    {
+      c_re = _mm256_maskload_pd(resume->c_re + x, lanes);
+      c_im = _mm256_maskload_pd(resume->c_im + x, lanes);
+    }
+    else if(row->column)
+    {
+      c_re = _mm256_set1_pd(row->c_re);
+      c_im = _mm256_sub_pd(MaxIm, _mm256_mul_pd(xs, factor));
+    }
+    else
+    {
+      c_re = _mm256_add_pd(MinRe, _mm256_mul_pd(xs, factor));
+      c_im = _mm256_set1_pd(row->c_im);
+    }
+    __m256d k_re = row->julia ? _mm256_set1_pd(row->k_re) : c_re;
+    __m256d k_im = row->julia ? _mm256_set1_pd(row->k_im) : c_im;
+
+    __m256d interior = _mm256_setzero_pd();
+    if(row->interior && !row->julia && resume == NULL)
+      interior = insideCardioidOrBulbAVX2(c_re, c_im);
+
+    Z_re = c_re;
+    Z_im = c_im;
+    __m256d count = _mm256_and_pd(interior, max);
+    if(resume != NULL)
+    {
+      Z_re = _mm256_maskload_pd(resume->z_re + x, lanes);
+      Z_im = _mm256_maskload_pd(resume->z_im + x, lanes);
+      count = _mm256_set1_pd(resume->first);
+    }
+    __m256d saved_re = Z_re, saved_im = Z_im;
+    unsigned period = 0, interval = BRENT_FIRST_INTERVAL;
+    __m256d escape_r2 = _mm256_setzero_pd();
+    __m256d active = _mm256_andnot_pd(interior, _mm256_castsi256_pd(lanes));
+
+    for(uint32_t n = resume != NULL ? resume->first : 0;
+        n < row->MaxIterations; n++)
+    {
+      __m256d Z_im2 = _mm256_mul_pd(Z_im, Z_im);
+      __m256d Z_re2 = _mm256_mul_pd(Z_re, Z_re);
+
+      // a lane stops counting at its first |z| > 2, like the scalar break
+      __m256d r2 = _mm256_add_pd(Z_re2, Z_im2);
+      __m256d inside = _mm256_cmp_pd(r2, four, _CMP_NGT_UQ);
+      if(magnitude != NULL)
+        escape_r2 = _mm256_blendv_pd(escape_r2, r2,
+                                     _mm256_andnot_pd(inside, active));
+      active = _mm256_and_pd(active, inside);
+      if(_mm256_movemask_pd(active) == 0)
+        break;
+      count = _mm256_add_pd(count, _mm256_and_pd(active, one));
+
+      Z_im = _mm256_add_pd(_mm256_mul_pd(_mm256_mul_pd(two, Z_re), Z_im),
+                           k_im);
+      Z_re = _mm256_add_pd(_mm256_sub_pd(Z_re2, Z_im2), k_re);
+
+      if(row->interior)
+      {
+        __m256d periodic = _mm256_and_pd(active,
+          _mm256_and_pd(_mm256_cmp_pd(Z_re, saved_re, _CMP_EQ_OQ),
+                        _mm256_cmp_pd(Z_im, saved_im, _CMP_EQ_OQ)));
+        count = _mm256_blendv_pd(count, max, periodic);
+        active = _mm256_andnot_pd(periodic, active);
+        if(++period == interval)
+        {
+          saved_re = Z_re;
+          saved_im = Z_im;
+          interval *= 2;
+          period = 0;
+        }
+      }
+    }
+
+    uint32_t result[4];
+    _mm_storeu_si128((__m128i*)result, _mm256_cvtpd_epi32(count));
+    memcpy(out + x - x0, result, valid * sizeof(uint32_t));
+    if(magnitude != NULL)
+    {
+      float r2[4];
+      _mm_storeu_ps(r2, _mm256_cvtpd_ps(escape_r2));
+      memcpy(magnitude + x - x0, r2, valid * sizeof(float));
+    }
+    if(state != NULL)
+    {
+      double re[4], im[4];
+      _mm256_storeu_pd(re, Z_re);
+      _mm256_storeu_pd(im, Z_im);
+      storeState(re, im, _mm256_movemask_pd(active), valid,
+                 state + 2*(x - x0));
+    }
+  }
+}
+
+__attribute__((target("avx2")))
+unsigned iterateRowDoubleAVX2(const double_row_t* row, unsigned x0,
+                              unsigned x1, uint32_t* out, float* magnitude,
+                              double* state)
+{
+  if(magnitude == NULL)
+    rowDoubleAVX2(row, NULL, x0, x1, out, NULL, state);
+  else
+    rowDoubleAVX2(row, NULL, x0, x1, out, magnitude, state);
+  return x1;
+}
+
+__attribute__((target("avx2")))
+unsigned resumeRowDoubleAVX2(const double_row_t* row,
+                             const double_resume_t* resume, unsigned x0,
+                             unsigned x1, uint32_t* out, float* magnitude,
+                             double* state)
+{
+  if(magnitude == NULL)
+    rowDoubleAVX2(row, resume, x0, x1, out, NULL, state);
+  else
+    rowDoubleAVX2(row, resume, x0, x1, out, magnitude, state);
+  return x1;
+}
+
+__attribute__((target("avx512f")))
+static inline __mmask8 insideCardioidOrBulbAVX512(__m512d c_re, __m512d c_im)
+{
+  __m512d c_im2 = _mm512_mul_pd(c_im, c_im);
+
+  __m512d x_q = _mm512_sub_pd(c_re, _mm512_set1_pd(0.25));
+  __m512d q = _mm512_add_pd(_mm512_mul_pd(x_q, x_q), c_im2);
+  __mmask8 cardioid = _mm512_cmp_pd_mask(
+    _mm512_mul_pd(q, _mm512_add_pd(q, x_q)),
+    _mm512_mul_pd(_mm512_set1_pd(0.25), c_im2), _CMP_LE_OQ);
+
+  __m512d x_b = _mm512_add_pd(c_re, _mm512_set1_pd(1.0));
+  __mmask8 bulb = _mm512_cmp_pd_mask(
+    _mm512_add_pd(_mm512_mul_pd(x_b, x_b), c_im2),
+    _mm512_set1_pd(0.0625), _CMP_LE_OQ);
+  return cardioid | bulb;
+}
+
+__attribute__((target("avx512f"), always_inline))
+static inline void rowDoubleAVX512(const double_row_t* row,
+                                   const double_resume_t* resume,
+                                   unsigned x0, unsigned x1, uint32_t* out,
+                                   float* magnitude, double* state)
+{
+  const __m512d four = _mm512_set1_pd(4.0);
+  const __m512d two = _mm512_set1_pd(2.0);
+  const __m512d one = _mm512_set1_pd(1.0);
+  const __m512d max = _mm512_set1_pd(row->MaxIterations);
+  const __m512d MinRe = _mm512_set1_pd(row->MinRe);
+  const __m512d factor = _mm512_set1_pd(row->factor);
+  const __m512d MaxIm = _mm512_set1_pd(row->MaxIm);
+
+  unsigned x = x0;
+  for(; x < x1; x += 8)
+  {
+    unsigned valid = x1 - x < 8 ? x1 - x : 8;
+    __mmask8 lanes = (1u << valid) - 1;
+    long s = row->stride, p = (long)x*s + row->offset;
+    __m512d xs = _mm512_set_pd(p + 7*s, p + 6*s, p + 5*s, p + 4*s,
+                               p + 3*s, p + 2*s, p + s, p);
+    __m512d c_re, c_im, Z_re, Z_im;
+    if(resume != NULL)
+    {
+      c_re = _mm512_maskz_loadu_pd(lanes, resume->c_re + x);
+      c_im = _mm512_maskz_loadu_pd(lanes, resume->c_im + x);
+    }
+    else if(row->column)
+    {
+      c_re = _mm512_set1_pd(row->c_re);
+      c_im = _mm512_sub_pd(MaxIm, _mm512_mul_pd(xs, factor));
+    }
+    else
+    {
+      c_re = _mm512_add_pd(MinRe, _mm512_mul_pd(xs, factor));
+      c_im = _mm512_set1_pd(row->c_im);
+    }
+    __m512d k_re = row->julia ? _mm512_set1_pd(row->k_re) : c_re;
+    __m512d k_im = row->julia ? _mm512_set1_pd(row->k_im) : c_im;
+
+    __mmask8 interior = 0;
+    if(row->interior && !row->julia && resume == NULL)
+      interior = insideCardioidOrBulbAVX512(c_re, c_im);
+
+    Z_re = c_re;
+    Z_im = c_im;
+    __m512d count = _mm512_maskz_mov_pd(interior, max);
+    if(resume != NULL)
+    {
+      Z_re = _mm512_maskz_loadu_pd(lanes, resume->z_re + x);
+      Z_im = _mm512_maskz_loadu_pd(lanes, resume->z_im + x);
+      count = _mm512_set1_pd(resume->first);
+    }
+    __m512d saved_re = Z_re, saved_im = Z_im;
+    unsigned period = 0, interval = BRENT_FIRST_INTERVAL;
+    __m512d escape_r2 = _mm512_setzero_pd();
+    __mmask8 active = ~interior & lanes;
+
+    for(uint32_t n = resume != NULL ? resume->first : 0;
+        n < row->MaxIterations; n++)
+    {
+      __m512d Z_im2 = _mm512_mul_pd(Z_im, Z_im);
+      __m512d Z_re2 = _mm512_mul_pd(Z_re, Z_re);
+
+      __m512d r2 = _mm512_add_pd(Z_re2, Z_im2);
+      __mmask8 inside = _mm512_mask_cmp_pd_mask(active, r2, four,
+                                                _CMP_NGT_UQ);
+      if(magnitude != NULL)
+        escape_r2 = _mm512_mask_mov_pd(escape_r2, active & ~inside, r2);
+      active = inside;
+      if(active == 0)
+        break;
+      count = _mm512_mask_add_pd(count, active, count, one);
+
+      Z_im = _mm512_add_pd(_mm512_mul_pd(_mm512_mul_pd(two, Z_re), Z_im),
+                           k_im);
+      Z_re = _mm512_add_pd(_mm512_sub_pd(Z_re2, Z_im2), k_re);
+
+      if(row->interior)
+      {
+        __mmask8 periodic =
+          _mm512_mask_cmp_pd_mask(active, Z_re, saved_re, _CMP_EQ_OQ)
+          & _mm512_cmp_pd_mask(Z_im, saved_im, _CMP_EQ_OQ);
+        count = _mm512_mask_mov_pd(count, periodic, max);
+        active &= ~periodic;
+        if(++period == interval)
+        {
+          saved_re = Z_re;
+          saved_im = Z_im;
+          interval *= 2;
+          period = 0;
+        }
+      }
+    }
+
+    uint32_t result[8];
+    _mm256_storeu_si256((__m256i*)result, _mm512_cvtpd_epi32(count));
+    memcpy(out + x - x0, result, valid * sizeof(uint32_t));
+    if(magnitude != NULL)
+    {
+      float r2[8];
+      _mm256_storeu_ps(r2, _mm512_cvtpd_ps(escape_r2));
+      memcpy(magnitude + x - x0, r2, valid * sizeof(float));
+    }
+    if(state != NULL)
+    {
+      double re[8], im[8];
+      _mm512_storeu_pd(re, Z_re);
+      _mm512_storeu_pd(im, Z_im);
+      storeState(re, im, active, valid, state + 2*(x - x0));
+    }
+  }
+}
+
+__attribute__((target("avx512f")))
+unsigned iterateRowDoubleAVX512(const double_row_t* row, unsigned x0,
+                                unsigned x1, uint32_t* out, float* magnitude,
+                                double* state)
+{
+  if(magnitude == NULL)
+    rowDoubleAVX512(row, NULL, x0, x1, out, NULL, state);
+  else
+    rowDoubleAVX512(row, NULL, x0, x1, out, magnitude, state);
+  return x1;
+}
+
+__attribute__((target("avx512f")))
+unsigned resumeRowDoubleAVX512(const double_row_t* row,
+                               const double_resume_t* resume, unsigned x0,
+                               unsigned x1, uint32_t* out, float* magnitude,
+                               double* state)
+{
+  if(magnitude == NULL)
+    rowDoubleAVX512(row, resume, x0, x1, out, NULL, state);
+  else
+    rowDoubleAVX512(row, resume, x0, x1, out, magnitude, state);
+  return x1;
+}
+
+// Low 64 bits of a signed 64x64 product, built from 32x32->64 multiplies
+__attribute__((target("avx2")))
+static inline __m256i mulLo64AVX2(__m256i a, __m256i b)
+{
+  __m256i low = _mm256_mul_epu32(a, b);
+  __m256i a_hi = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), b);
+  __m256i b_hi = _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32));
+  __m256i cross = _mm256_add_epi64(a_hi, b_hi);
+  return _mm256_add_epi64(low, _mm256_slli_epi64(cross, 32));
+}
+
+// AVX2 has no 64-bit arithmetic shift, fill in the sign bits by hand
+__attribute__((target("avx2")))
+static inline __m256i shiftNormAVX2(__m256i a)
+{
+  __m256i sign = _mm256_cmpgt_epi64(_mm256_setzero_si256(), a);
+  return _mm256_or_si256(_mm256_srli_epi64(a, NORM_BITS),
+                         _mm256_slli_epi64(sign, 64 - NORM_BITS));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i multFixedAVX2(__m256i a, __m256i b)
+{
+  return shiftNormAVX2(mulLo64AVX2(a, b));
+}
+
+// Per-lane c, computed with the scalar macro so rounding matches.
+// Returns a bit mask of the lanes known to be inside the set.
+static inline unsigned fixedRowCoordinates(const fixed_row_t* row,
+                                           unsigned x, unsigned lanes,
+                                           fixed_point_t* c_re,
+                                           fixed_point_t* c_im)
+{
+  unsigned interior = 0;
+  for(unsigned i = 0; i < lanes; i++)
+  {
+    long lane_x = ((long)x + i)*row->stride + row->offset;
+    if(row->column)
+    {
+      c_re[i] = row->c_re;
+      c_im[i] = row->MaxIm - multFixed(floatToFixed(lane_x), row->factor);
+    }
+    else
+    {
+      c_re[i] = row->MinRe + multFixed(floatToFixed(lane_x), row->factor);
+      c_im[i] = row->c_im;
+    }
+    if(row->interior && !row->julia
+       && insideCardioidOrBulbFixed(c_re[i], c_im[i]))
+      interior |= 1u << i;
+  }
+  return interior;
+}
+
+// |z|^2 of lanes whose z escaped at (re[i], im[i]), in double like the
+// scalar kernel since the squares can overflow 4.29
+static inline void storeFixedMagnitudes(const fixed_point_t* re,
+                                        const fixed_point_t* im,
+                                        unsigned lanes, float* magnitude)
+{
+  for(unsigned i = 0; i < lanes; i++)
+  {
+    double z_re = fixedToFloat(re[i]), z_im = fixedToFloat(im[i]);
+    magnitude[i] = z_re*z_re + z_im*z_im;
+  }
+}
+
+// Lanes of a 4.29 resume array from a[0], zero past the valid ones
+static inline void loadFixedLanes(const fixed_point_t* a, unsigned valid,
+                                  unsigned lanes, fixed_point_t* out)
+{
+  for(unsigned i = 0; i < lanes; i++)
+    out[i] = i < valid ? a[i] : 0;
+}
+
+// storeState() of 4.29 lanes, a z that has not escaped is exact in double
+static inline void storeFixedState(const fixed_point_t* re,
+                                   const fixed_point_t* im, unsigned capped,
+                                   unsigned lanes, double* state)
+{
+  double z_re[8], z_im[8];
+  for(unsigned i = 0; i < lanes; i++)
+  {
+    z_re[i] = fixedToFloat(re[i]);
+    z_im[i] = fixedToFloat(im[i]);
+  }
+  storeState(z_re, z_im, capped, lanes, state);
+}
+
+__attribute__((target("avx2"), always_inline))
+static inline void rowFixedAVX2(const fixed_row_t* row,
+                                const fixed_resume_t* resume, unsigned x0,
+                                unsigned x1, uint32_t* out, float* magnitude,
+                                double* state)
+{
+  const __m256i four = _mm256_set1_epi64x(floatToFixed(4));
+  const __m256i narrow_bias = _mm256_set1_epi64x(1L << 31);
+  const __m256i max = _mm256_set1_epi64x(row->MaxIterations);
+
+  unsigned x = x0;
+  for(; x < x1; x += 4)
+  {
+    // lanes past x1 start inactive and are not stored
+    unsigned valid = x1 - x < 4 ? x1 - x : 4;
+    fixed_point_t lanes[4], lanes_im[4];
+    unsigned inside_bits = 0;
+    if(resume != NULL)
+    {
+      loadFixedLanes(resume->c_re + x, valid, 4, lanes);
+      loadFixedLanes(resume->c_im + x, valid, 4, lanes_im);
+    }
+    else
+      inside_bits = fixedRowCoordinates(row, x, 4, lanes, lanes_im);
+    __m256i c_re = _mm256_loadu_si256((const __m256i*)lanes);
+    __m256i c_im = _mm256_loadu_si256((const __m256i*)lanes_im);
+    __m256i k_re = row->julia ? _mm256_set1_epi64x(row->k_re) : c_re;
+    __m256i k_im = row->julia ? _mm256_set1_epi64x(row->k_im) : c_im;
+
+    __m256i interior = _mm256_set_epi64x(-(long)((inside_bits >> 3) & 1),
+                                         -(long)((inside_bits >> 2) & 1),
+                                         -(long)((inside_bits >> 1) & 1),
+                                         -(long)(inside_bits & 1));
+    __m256i Z_re = c_re, Z_im = c_im;
+    __m256i count = _mm256_and_si256(interior, max);
+    if(resume != NULL)
+    {
+      loadFixedLanes(resume->z_re + x, valid, 4, lanes);
+      loadFixedLanes(resume->z_im + x, valid, 4, lanes_im);
+      Z_re = _mm256_loadu_si256((const __m256i*)lanes);
+      Z_im = _mm256_loadu_si256((const __m256i*)lanes_im);
+      count = _mm256_set1_epi64x(resume->first);
+    }
+    __m256i saved_re = Z_re, saved_im = Z_im;
+    unsigned period = 0, interval = BRENT_FIRST_INTERVAL;
+    __m256i escape_re = _mm256_setzero_si256();
+    __m256i escape_im = _mm256_setzero_si256();
+    __m256i active = _mm256_andnot_si256(interior,
+      _mm256_cmpgt_epi64(_mm256_set1_epi64x(valid),
+                         _mm256_set_epi64x(3, 2, 1, 0)));
+
+    for(uint32_t n = resume != NULL ? resume->first : 0;
+        n < row->MaxIterations; n++)
+    {
+      // while every active lane fits in 32 bits (|z| < 4, the common case)
+      // _mm256_mul_epi32 already gives the exact 64-bit product
+      __m256i high = _mm256_or_si256(
+        _mm256_srli_epi64(_mm256_add_epi64(Z_re, narrow_bias), 32),
+        _mm256_srli_epi64(_mm256_add_epi64(Z_im, narrow_bias), 32));
+      bool narrow = _mm256_testz_si256(high, active);
+
+      __m256i Z_im2, Z_re2, product;
+      if(narrow)
+      {
+        Z_im2 = shiftNormAVX2(_mm256_mul_epi32(Z_im, Z_im));
+        Z_re2 = shiftNormAVX2(_mm256_mul_epi32(Z_re, Z_re));
+      }
+      else
+      {
+        Z_im2 = multFixedAVX2(Z_im, Z_im);
+        Z_re2 = multFixedAVX2(Z_re, Z_re);
+      }
+
+      __m256i escaped = _mm256_cmpgt_epi64(_mm256_add_epi64(Z_re2, Z_im2),
+                                           four);
+      if(magnitude != NULL)
+      {
+        __m256i now = _mm256_and_si256(escaped, active);
+        escape_re = _mm256_blendv_epi8(escape_re, Z_re, now);
+        escape_im = _mm256_blendv_epi8(escape_im, Z_im, now);
+      }
+      active = _mm256_andnot_si256(escaped, active);
+      if(_mm256_testz_si256(active, active))
+        break;
+      count = _mm256_sub_epi64(count, active); // active lanes are -1
+
+      if(narrow)
+        product = shiftNormAVX2(_mm256_mul_epi32(Z_re, Z_im));
+      else
+        product = multFixedAVX2(Z_re, Z_im);
+
+      // multFixed(floatToFixed(2), t) == (t << 30) >> 29 with wrap-around
+      Z_im = _mm256_add_epi64(shiftNormAVX2(_mm256_slli_epi64(product,
+                                                              NORM_BITS + 1)),
+                              k_im);
+      Z_re = _mm256_add_epi64(_mm256_sub_epi64(Z_re2, Z_im2), k_re);
+
+      if(row->interior)
+      {
+        __m256i periodic = _mm256_and_si256(active,
+          _mm256_and_si256(_mm256_cmpeq_epi64(Z_re, saved_re),
+                           _mm256_cmpeq_epi64(Z_im, saved_im)));
+        count = _mm256_blendv_epi8(count, max, periodic);
+        active = _mm256_andnot_si256(periodic, active);
+        if(++period == interval)
+        {
+          saved_re = Z_re;
+          saved_im = Z_im;
+          interval *= 2;
+          period = 0;
+        }
+      }
+    }
+
+    _mm256_storeu_si256((__m256i*)lanes, count);
+    for(unsigned i = 0; i < valid; i++)
+      out[x - x0 + i] = lanes[i];
+    if(magnitude != NULL)
+    {
+      _mm256_storeu_si256((__m256i*)lanes, escape_re);
+      _mm256_storeu_si256((__m256i*)lanes_im, escape_im);
+      storeFixedMagnitudes(lanes, lanes_im, valid, magnitude + x - x0);
+    }
+    if(state != NULL)
+    {
+      _mm256_storeu_si256((__m256i*)lanes, Z_re);
+      _mm256_storeu_si256((__m256i*)lanes_im, Z_im);
+      storeFixedState(lanes, lanes_im,
+                      _mm256_movemask_pd(_mm256_castsi256_pd(active)), valid,
+                      state + 2*(x - x0));
+    }
+  }
+}
+
+__attribute__((target("avx2")))
+unsigned iterateRowFixedAVX2(const fixed_row_t* row, unsigned x0,
+                             unsigned x1, uint32_t* out, float* magnitude,
+                             double* state)
+{
+  if(magnitude == NULL)
+    rowFixedAVX2(row, NULL, x0, x1, out, NULL, state);
+  else
+    rowFixedAVX2(row, NULL, x0, x1, out, magnitude, state);
+  return x1;
+}
+
+__attribute__((target("avx2")))
+unsigned resumeRowFixedAVX2(const fixed_row_t* row,
+                            const fixed_resume_t* resume, unsigned x0,
+                            unsigned x1, uint32_t* out, float* magnitude,
+                            double* state)
+{
+  if(magnitude == NULL)
+    rowFixedAVX2(row, resume, x0, x1, out, NULL, state);
+  else
+    rowFixedAVX2(row, resume, x0, x1, out, magnitude, state);
+  return x1;
+}
+
+__attribute__((target("avx512f,avx512dq")))
+static inline __m512i multFixedAVX512(__m512i a, __m512i b)
+{
+  return _mm512_srai_epi64(_mm512_mullo_epi64(a, b), NORM_BITS);
+}
+
+__attribute__((target("avx512f,avx512dq"), always_inline))
+static inline void rowFixedAVX512(const fixed_row_t* row,
+                                  const fixed_resume_t* resume, unsigned x0,
+                                  unsigned x1, uint32_t* out,
+                                  float* magnitude, double* state)
+{
+  const __m512i four = _mm512_set1_epi64(floatToFixed(4));
+  const __m512i one = _mm512_set1_epi64(1);
+  const __m512i max = _mm512_set1_epi64(row->MaxIterations);
+
+  unsigned x = x0;
+  for(; x < x1; x += 8)
+  {
+    unsigned valid = x1 - x < 8 ? x1 - x : 8;
+    __mmask8 lanes_valid = (1u << valid) - 1;
+    fixed_point_t lanes[8], lanes_im[8];
+    __mmask8 interior = 0;
+    __m512i c_re, c_im;
+    if(resume != NULL)
+    {
+      c_re = _mm512_maskz_loadu_epi64(lanes_valid, resume->c_re + x);
+      c_im = _mm512_maskz_loadu_epi64(lanes_valid, resume->c_im + x);
+    }
+    else
+    {
+      interior = fixedRowCoordinates(row, x, 8, lanes, lanes_im);
+      c_re = _mm512_loadu_si512(lanes);
+      c_im = _mm512_loadu_si512(lanes_im);
+    }
+    __m512i k_re = row->julia ? _mm512_set1_epi64(row->k_re) : c_re;
+    __m512i k_im = row->julia ? _mm512_set1_epi64(row->k_im) : c_im;
+
+    __m512i Z_re = c_re, Z_im = c_im;
+    __m512i count = _mm512_maskz_mov_epi64(interior, max);
+    if(resume != NULL)
+    {
+      Z_re = _mm512_maskz_loadu_epi64(lanes_valid, resume->z_re + x);
+      Z_im = _mm512_maskz_loadu_epi64(lanes_valid, resume->z_im + x);
+      count = _mm512_set1_epi64(resume->first);
+    }
+    __m512i saved_re = Z_re, saved_im = Z_im;
+    unsigned period = 0, interval = BRENT_FIRST_INTERVAL;
+    __m512i escape_re = _mm512_setzero_si512();
+    __m512i escape_im = _mm512_setzero_si512();
+    __mmask8 active = ~interior & lanes_valid;
+
+    for(uint32_t n = resume != NULL ? resume->first : 0;
+        n < row->MaxIterations; n++)
+    {
+      __m512i Z_im2 = multFixedAVX512(Z_im, Z_im);
+      __m512i Z_re2 = multFixedAVX512(Z_re, Z_re);
+
+      __mmask8 inside = _mm512_mask_cmple_epi64_mask(active,
+        _mm512_add_epi64(Z_re2, Z_im2), four);
+      if(magnitude != NULL)
+      {
+        escape_re = _mm512_mask_mov_epi64(escape_re, active & ~inside, Z_re);
+        escape_im = _mm512_mask_mov_epi64(escape_im, active & ~inside, Z_im);
+      }
+      active = inside;
+      if(active == 0)
+        break;
+      count = _mm512_mask_add_epi64(count, active, count, one);
+
+      __m512i product = multFixedAVX512(Z_re, Z_im);
+      Z_im = _mm512_add_epi64(_mm512_srai_epi64(_mm512_slli_epi64(product,
+                                                                  NORM_BITS + 1),
+                                                NORM_BITS),
+                              k_im);
+      Z_re = _mm512_add_epi64(_mm512_sub_epi64(Z_re2, Z_im2), k_re);
+
+      if(row->interior)
+      {
+        __mmask8 periodic =
+          _mm512_mask_cmpeq_epi64_mask(active, Z_re, saved_re)
+          & _mm512_cmpeq_epi64_mask(Z_im, saved_im);
+        count = _mm512_mask_mov_epi64(count, periodic, max);
+        active &= ~periodic;
+        if(++period == interval)
+        {
+          saved_re = Z_re;
+          saved_im = Z_im;
+          interval *= 2;
+          period = 0;
+        }
+      }
+    }
+
+    uint32_t result[8];
+    _mm256_storeu_si256((__m256i*)result, _mm512_cvtepi64_epi32(count));
+    memcpy(out + x - x0, result, valid * sizeof(uint32_t));
+    if(magnitude != NULL)
+    {
+      _mm512_storeu_si512(lanes, escape_re);
+      _mm512_storeu_si512(lanes_im, escape_im);
+      storeFixedMagnitudes(lanes, lanes_im, valid, magnitude + x - x0);
+    }
+    if(state != NULL)
+    {
+      _mm512_storeu_si512(lanes, Z_re);
+      _mm512_storeu_si512(lanes_im, Z_im);
+      storeFixedState(lanes, lanes_im, active, valid, state + 2*(x - x0));
+    }
+  }
+}
+
+__attribute__((target("avx512f,avx512dq")))
+unsigned iterateRowFixedAVX512(const fixed_row_t* row, unsigned x0,
+                               unsigned x1, uint32_t* out, float* magnitude,
+                               double* state)
+{
+  if(magnitude == NULL)
+    rowFixedAVX512(row, NULL, x0, x1, out, NULL, state);
+  else
+    rowFixedAVX512(row, NULL, x0, x1, out, magnitude, state);
+  return x1;
+}
+
+__attribute__((target("avx512f,avx512dq")))
+unsigned resumeRowFixedAVX512(const fixed_row_t* row,
+                              const fixed_resume_t* resume, unsigned x0,
+                              unsigned x1, uint32_t* out, float* magnitude,
+                              double* state)
+{
+  if(magnitude == NULL)
+    rowFixedAVX512(row, resume, x0, x1, out, NULL, state);
+  else
+    rowFixedAVX512(row, resume, x0, x1, out, magnitude, state);
+  return x1;
+}
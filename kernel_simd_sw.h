@@ -0,0 +1,137 @@
+#ifndef KERNEL_SIMD_SW_H
+#define KERNEL_SIMD_SW_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "fixed_point_sw.h"
+
+/*
+  Vectorised escape-time kernels. Every lane runs exactly the scalar
+  operation sequence of render_sw.c (no FMA contraction), so iteration
+  counts are bit-identical to the scalar loop. Pixel x is written to
+  out[x - x0]; a short last vector runs with its extra lanes masked off,
+  so short spans stay vectorised. Unless magnitude is NULL, |z|^2 at the
+  iteration a pixel escaped is written to magnitude[x - x0] too, for
+  smooth colouring. Unless state is NULL, state[2(x - x0)] and
+  state[2(x - x0) + 1] get the real and imaginary part of z for pixels that
+  ran to MaxIterations and NaN for all others, so that they can be resumed
+  with a higher limit. The kernels return the first pixel they did not
+  compute, which is always x1.
+*/
+
+typedef enum
+{
+  SIMD_SCALAR,
+  SIMD_AVX2,      // 4 doubles / 64-bit integers per vector
+  SIMD_AVX512     // 8 doubles / 64-bit integers per vector (needs F and DQ)
+} simd_level_t;
+
+// Widest level supported by the CPU and OS, capped by $MANDELBROT_SIMD
+// (scalar, avx2 or avx512) when it is set
+simd_level_t detectSimdLevel();
+
+// Parses "scalar", "avx2" or "avx512", returns -1 if unknown
+int parseSimdLevel(const char* name);
+
+const char* simdLevelName(simd_level_t level);
+
+// One row of a double-precision view: c = (MinRe + x*factor, c_im). With
+// column set the kernel walks down a column instead and x is the row:
+// c = (c_re, MaxIm - x*factor). Pixel x sits at x*stride + offset in the
+// formulas.
+typedef struct
+{
+  double MinRe;
+  double factor;
+  double c_im;
+  bool column;
+  double c_re;
+  double MaxIm;
+  int32_t stride;
+  int32_t offset;
+  bool julia;       // add (k_re, k_im) instead of c
+  double k_re;
+  double k_im;
+  uint32_t MaxIterations;
+  bool interior;    // cardioid/bulb test and cycle detection, see interior_sw.h
+} double_row_t;
+
+unsigned iterateRowDoubleAVX2(const double_row_t* row, unsigned x0,
+                              unsigned x1, uint32_t* out,
+                              float* magnitude, double* state);
+unsigned iterateRowDoubleAVX512(const double_row_t* row, unsigned x0,
+                                unsigned x1, uint32_t* out,
+                                float* magnitude, double* state);
+
+// Pixels carried on from a lower limit: pixel x has c = (c_re[x], c_im[x])
+// and continues from z = (z_re[x], z_im[x]) after `first` iterations. Only
+// julia, k_re, k_im, MaxIterations and interior of the row are used, and
+// cycle detection starts over from z.
+typedef struct
+{
+  const double* c_re;
+  const double* c_im;
+  const double* z_re;
+  const double* z_im;
+  uint32_t first;
+} double_resume_t;
+
+unsigned resumeRowDoubleAVX2(const double_row_t* row,
+                             const double_resume_t* resume, unsigned x0,
+                             unsigned x1, uint32_t* out, float* magnitude,
+                             double* state);
+unsigned resumeRowDoubleAVX512(const double_row_t* row,
+                               const double_resume_t* resume, unsigned x0,
+                               unsigned x1, uint32_t* out, float* magnitude,
+                               double* state);
+
+// One row of a 4.29 view: c = (MinRe + multFixed(floatToFixed(x), factor),
+// c_im), or with column set c = (c_re, MaxIm - multFixed(floatToFixed(x),
+// factor)). Lanes reproduce the scalar 64-bit wrap-around and arithmetic
+// shift of multFixed exactly. As above, pixel x sits at x*stride + offset.
+typedef struct
+{
+  fixed_point_t MinRe;
+  fixed_point_t factor;
+  fixed_point_t c_im;
+  bool column;
+  fixed_point_t c_re;
+  fixed_point_t MaxIm;
+  int32_t stride;
+  int32_t offset;
+  bool julia;
+  fixed_point_t k_re;
+  fixed_point_t k_im;
+  uint32_t MaxIterations;
+  bool interior;
+} fixed_row_t;
+
+unsigned iterateRowFixedAVX2(const fixed_row_t* row, unsigned x0,
+                             unsigned x1, uint32_t* out,
+                             float* magnitude, double* state);
+unsigned iterateRowFixedAVX512(const fixed_row_t* row, unsigned x0,
+                               unsigned x1, uint32_t* out,
+                               float* magnitude, double* state);
+
+// 4.29 counterpart of double_resume_t; the state is still written in
+// double, which holds any z of a pixel that has not escaped exactly
+typedef struct
+{
+  const fixed_point_t* c_re;
+  const fixed_point_t* c_im;
+  const fixed_point_t* z_re;
+  const fixed_point_t* z_im;
+  uint32_t first;
+} fixed_resume_t;
+
+unsigned resumeRowFixedAVX2(const fixed_row_t* row,
+                            const fixed_resume_t* resume, unsigned x0,
+                            unsigned x1, uint32_t* out, float* magnitude,
+                            double* state);
+unsigned resumeRowFixedAVX512(const fixed_row_t* row,
+                              const fixed_resume_t* resume, unsigned x0,
+                              unsigned x1, uint32_t* out, float* magnitude,
+                              double* state);
+
+#endif // KERNEL_SIMD_SW_H
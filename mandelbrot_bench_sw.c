@@ -0,0 +1,324 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <time.h>
+
+#include "render_sw.h"
+
+/*
+  Benchmark harness: renders a fixed set of views with each kernel at a few
+  sizes and reports Mpixel/s, iterations/s and percentiles of the frame
+  latency, split into computing the counts, colouring them and the whole
+  frame. Results go to stderr as a table and optionally to a JSON file, one
+  object per run, so that runs of two commits can be diffed. The tile cache
+  and store are off, every frame is iterated.
+*/
+
+// Frames per run: at least MIN_FRAMES and MIN_SECONDS worth, at most
+// MAX_FRAMES
+#define MIN_FRAMES 5
+#define MAX_FRAMES 200
+#define MIN_SECONDS 0.5
+
+typedef struct
+{
+  const char* name;
+  fractal_t fractal;
+  numeric_t numeric;
+} bench_kernel_t;
+
+typedef struct
+{
+  const char* name;
+  double cRe;       // Mandelbrot views
+  double cIm;
+  double jRe;       // the same view for the Julia set
+  double jIm;
+  double zoom;
+  uint32_t MaxIterations;
+} bench_view_t;
+
+typedef struct
+{
+  double p50, p90, p99, mean;
+} latency_t;
+
+static const bench_kernel_t kernels[] = {
+  {"double", FRACTAL_MANDELBROT, NUMERIC_DOUBLE},
+  {"fixed-4.29", FRACTAL_MANDELBROT, NUMERIC_FIXED},
+  {"julia", FRACTAL_JULIA, NUMERIC_DOUBLE}
+};
+
+// The deep interior is the period-3 bulb, where only cycle detection
+// helps. The viewers' Julia constant gives a disconnected set without an
+// interior, its views zoom into the set's slowest regions instead.
+static const bench_view_t views[] = {
+  {"full", -0.5, 0, 0, 0, 1, 50},
+  {"valley", -0.76, -0.102, 0.07, -0.9, 4, 200},
+  {"seahorse", -0.743643887037151, 0.131825904205330,
+   0.072731607933793, -0.925531303043781, 1000, 1000},
+  {"deep-interior", -0.1225611669, 0.7448617666, 0, 0, 50, 1000}
+};
+
+#define COUNT(array) (sizeof(array) / sizeof(array[0]))
+
+static void usage(const char* program)
+{
+  fprintf(stderr,
+    "Usage: %s [options]\n"
+    "  -s, --sizes WxH[,WxH...]         frame sizes (256x256,800x800,\n"
+    "                                   1920x1080)\n"
+    "  -k, --kernel NAME                only this kernel: double,\n"
+    "                                   fixed-4.29 or julia (all)\n"
+    "  -w, --view NAME                  only this view: full, valley,\n"
+    "                                   seahorse or deep-interior (all)\n"
+    "  -t, --threads N                  render threads (all CPUs)\n"
+    "  -v, --simd scalar|avx2|avx512    vector kernel (widest supported)\n"
+    "  -j, --json FILE                  also write the results as JSON\n",
+    program);
+}
+
+static double now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int compareDouble(const void* a, const void* b)
+{
+  double x = *(const double*)a, y = *(const double*)b;
+  return x < y ? -1 : x > y;
+}
+
+// Nearest-rank percentiles of count samples in milliseconds, sorts them
+static latency_t percentiles(double* samples, unsigned count)
+{
+  latency_t latency = {0};
+  qsort(samples, count, sizeof(double), compareDouble);
+  for(unsigned i = 0; i < count; i++)
+    latency.mean += samples[i] / count;
+  latency.p50 = samples[(count - 1) * 50 / 100];
+  latency.p90 = samples[(count - 1) * 90 / 100];
+  latency.p99 = samples[(count - 1) * 99 / 100];
+  return latency;
+}
+
+static void printLatency(FILE* json, const char* name, latency_t latency)
+{
+  fprintf(json, "\"%s\": {\"mean\": %.4f, \"p50\": %.4f, \"p90\": %.4f, "
+          "\"p99\": %.4f}", name, latency.mean, latency.p50, latency.p90,
+          latency.p99);
+}
+
+// Renders one kernel, view and size until enough frames are timed, writes
+// the table row and the JSON object (unless json is NULL)
+static int runBench(const bench_kernel_t* kernel, const bench_view_t* bview,
+                    uint32_t width, uint32_t height, FILE* json, bool first)
+{
+  bool julia = kernel->fractal == FRACTAL_JULIA;
+  view_t view = {
+    .fractal = kernel->fractal,
+    .numeric = kernel->numeric,
+    .width = width,
+    .height = height,
+    .MaxIterations = bview->MaxIterations,
+    .cRe = julia ? bview->jRe : bview->cRe,
+    .cIm = julia ? bview->jIm : bview->cIm,
+    .step = zoomToStep(bview->zoom, height),
+    .kRe = -0.5,
+    .kIm = 0.65,
+    .power = 3
+  };
+  size_t count = (size_t)width * height;
+  uint32_t* iterations = malloc(count * sizeof(uint32_t));
+  uint32_t* pixels = malloc(count * sizeof(uint32_t));
+  double compute[MAX_FRAMES], colour[MAX_FRAMES], frame[MAX_FRAMES];
+  if(iterations == NULL || pixels == NULL)
+  {
+    free(iterations);
+    free(pixels);
+    perror("Could not allocate frame buffers");
+    return -1;
+  }
+
+  // one untimed frame to fault in the buffers and start the threads
+  computeIterations(&view, iterations);
+
+  unsigned frames = 0;
+  double total = 0;
+  while(frames < MAX_FRAMES && (frames < MIN_FRAMES || total < MIN_SECONDS))
+  {
+    double start = now();
+    computeIterations(&view, iterations);
+    double computed = now();
+    colourIterations(&view, iterations, pixels);
+    double coloured = now();
+
+    compute[frames] = (computed - start) * 1e3;
+    colour[frames] = (coloured - computed) * 1e3;
+    frame[frames] = (coloured - start) * 1e3;
+    total += coloured - start;
+    frames++;
+  } // while
+
+  // counts of interior points are MaxIterations whether or not they were
+  // iterated that far, so this is the work brute force would do
+  double per_frame = 0;
+  for(size_t i = 0; i < count; i++)
+    per_frame += iterations[i];
+
+  latency_t compute_ms = percentiles(compute, frames);
+  latency_t colour_ms = percentiles(colour, frames);
+  latency_t frame_ms = percentiles(frame, frames);
+  double seconds = compute_ms.mean * 1e-3;
+  double mpixels = count / seconds * 1e-6;
+  double iterations_s = per_frame / seconds;
+
+  fprintf(stderr, "%-11s %-14s %5ux%-5u %4u  %8.2f %10.1f %8.3f %8.3f "
+          "%8.3f %8.3f\n", kernel->name, bview->name, width, height,
+          frames, mpixels, iterations_s * 1e-6, compute_ms.p50,
+          compute_ms.p99, colour_ms.p50, frame_ms.p99);
+
+  if(json != NULL)
+  {
+    fprintf(json, "%s    {\"kernel\": \"%s\", \"view\": \"%s\", "
+            "\"width\": %u, \"height\": %u, \"max_iterations\": %u, "
+            "\"frames\": %u, \"mpixels_per_s\": %.3f, "
+            "\"iterations_per_s\": %.0f, \"mean_iterations\": %.2f,\n     ",
+            first ? "" : ",\n", kernel->name, bview->name, width, height,
+            view.MaxIterations, frames, mpixels, iterations_s,
+            per_frame / count);
+    printLatency(json, "compute_ms", compute_ms);
+    fprintf(json, ",\n     ");
+    printLatency(json, "colour_ms", colour_ms);
+    fprintf(json, ",\n     ");
+    printLatency(json, "frame_ms", frame_ms);
+    fprintf(json, "}");
+  }
+
+  free(iterations);
+  free(pixels);
+  return 0;
+}
+
+int main(int argc, char* argv[])
+{
+  const char* sizes = "256x256,800x800,1920x1080";
+  const char* only_kernel = NULL;
+  const char* only_view = NULL;
+  const char* json_path = NULL;
+
+  static const struct option options[] = {
+    {"sizes", required_argument, NULL, 's'},
+    {"kernel", required_argument, NULL, 'k'},
+    {"view", required_argument, NULL, 'w'},
+    {"threads", required_argument, NULL, 't'},
+    {"simd", required_argument, NULL, 'v'},
+    {"json", required_argument, NULL, 'j'},
+    {"help", no_argument, NULL, 'h'},
+    {NULL, 0, NULL, 0}
+  };
+
+  int opt;
+  while((opt = getopt_long(argc, argv, "s:k:w:t:v:j:h", options, NULL))
+        != -1)
+  {
+    bool ok = true;
+    switch(opt)
+    {
+      case 's':
+        sizes = optarg;
+        break;
+      case 'k':
+        only_kernel = optarg;
+        break;
+      case 'w':
+        only_view = optarg;
+        break;
+      case 't':
+        ok = atoi(optarg) > 0;
+        if(ok)
+          setRenderThreads(atoi(optarg));
+        break;
+      case 'v':
+        ok = parseSimdLevel(optarg) >= 0;
+        if(ok)
+          setRenderSimd(parseSimdLevel(optarg));
+        break;
+      case 'j':
+        json_path = optarg;
+        break;
+      default:
+        ok = false;
+        break;
+    } // switch
+
+    if(!ok)
+    {
+      usage(argv[0]);
+      return opt == 'h' ? 0 : 1;
+    }
+  } // while
+
+  setTileCacheBudget(0);
+  setTileStore(NULL);
+  setFixedFormat(FIXED_4_29);
+
+  FILE* json = NULL;
+  if(json_path != NULL && (json = fopen(json_path, "w")) == NULL)
+  {
+    perror(json_path);
+    return 1;
+  }
+  if(json != NULL)
+    fprintf(json, "{\"threads\": %u, \"simd\": \"%s\", \"interior\": %s, "
+            "\"results\": [\n", renderThreads(),
+            simdLevelName(renderSimd()), interiorDetection() ? "true"
+                                                               : "false");
+
+  fprintf(stderr, "%u threads, %s\n", renderThreads(),
+          simdLevelName(renderSimd()));
+  fprintf(stderr, "%-11s %-14s %11s %5s %9s %10s %8s %8s %8s %8s\n",
+          "kernel", "view", "size", "frms", "Mpixel/s", "Miter/s",
+          "p50 ms", "p99 ms", "colour", "frame99");
+
+  bool first = true;
+  int status = 0;
+  for(size_t k = 0; k < COUNT(kernels) && status == 0; k++)
+  {
+    if(only_kernel != NULL && strcmp(only_kernel, kernels[k].name) != 0)
+      continue;
+    for(size_t v = 0; v < COUNT(views) && status == 0; v++)
+    {
+      if(only_view != NULL && strcmp(only_view, views[v].name) != 0)
+        continue;
+      const char* size = sizes;
+      while(size != NULL && status == 0)
+      {
+        uint32_t width, height;
+        if(sscanf(size, "%ux%u", &width, &height) != 2 || width == 0
+           || height == 0)
+        {
+          usage(argv[0]);
+          status = 1;
+          break;
+        }
+        status = runBench(&kernels[k], &views[v], width, height, json,
+                          first) == 0 ? 0 : 1;
+        first = false;
+        size = strchr(size, ',');
+        if(size != NULL)
+          size++;
+      } // while
+    } // for
+  } // for
+
+  if(json != NULL)
+  {
+    fprintf(json, "\n]}\n");
+    fclose(json);
+  }
+  return status;
+}
@@ -0,0 +1,475 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <time.h>
+
+#include "render_sw.h"
+#include "palette_sw.h"
+#include "iteration_budget_sw.h"
+#include "antialias_sw.h"
+#include "image_sw.h"
+
+/*
+  Headless renderer: computes one view without an X server and writes it
+  as PPM or PNG, reporting the render throughput on stderr.
+*/
+
+static void usage(const char* program)
+{
+  fprintf(stderr,
+    "Usage: %s [options]\n"
+    "  -f, --fractal mandelbrot|julia|burning-ship|multibrot\n"
+    "                                   fractal to render (mandelbrot)\n"
+    "  -p, --power 3|4                  multibrot exponent (3)\n"
+    "  -n, --numeric double|float|fixed|perturbation\n"
+    "                                   number format (double)\n"
+    "  -c, --center RE,IM               image centre (-0.76,-0.102), to any\n"
+    "                                   number of digits but with double\n"
+    "  -F, --fixed-format auto|4.29|4.60|4.124\n"
+    "                                   fixed-point format (auto)\n"
+    "  -z, --zoom Z                     zoom factor (1)\n"
+    "  -s, --size WxH                   image size (800x800)\n"
+    "  -i, --iterations N               maximum iterations (50)\n"
+    "  -k, --julia-constant RE,IM       Julia constant (-0.5,0.65)\n"
+    "  -t, --threads N                  render threads (all CPUs)\n"
+    "  -v, --simd scalar|avx2|avx512    vector kernel (widest supported)\n"
+    "  -I, --no-interior                iterate interior points to the limit\n"
+    "  -S, --series                     skip iterations with a series\n"
+    "                                   approximation (perturbation only)\n"
+    "  -m, --mode brute|mariani-silver|progressive\n"
+    "                                   render mode (brute)\n"
+    "  -V, --verify                     compare against a brute-force render\n"
+    "  -r, --repeat N                   render N times for timing (1)\n"
+    "  -C, --cache MB                   tile cache budget, repeats are then\n"
+    "                                   copied from it (0, off)\n"
+    "  -T, --store FILE                 tile store to serve tiles from and\n"
+    "                                   append new ones to\n"
+    "  -P, --palette NAME|FILE          smooth colouring with a built-in\n"
+    "                                   palette (ultra, fire, ocean, grey,\n"
+    "                                   rainbow) or one read from FILE\n"
+    "  -Q, --period N                   iterations per palette cycle (32)\n"
+    "  -R, --resume-from N              compute with N iterations first and\n"
+    "                                   time carrying that frame on to -i\n"
+    "  -A, --adaptive                   choose the iteration limit from the\n"
+    "                                   zoom and the escape counts, at most\n"
+    "                                   -i if given\n"
+    "  -a, --antialias N                supersample pixels on an edge of the\n"
+    "                                   counts with NxN samples (off)\n"
+    "  -o, --output FILE                .png or .ppm output (mandelbrot.ppm)\n",
+    program);
+}
+
+static int parsePair(const char* text, double* a, double* b)
+{
+  return sscanf(text, "%lf,%lf", a, b) == 2 ? 0 : -1;
+}
+
+static double now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char* argv[])
+{
+  view_t view = {
+    .fractal = FRACTAL_MANDELBROT,
+    .numeric = NUMERIC_DOUBLE,
+    .width = 800,
+    .height = 800,
+    .MaxIterations = 50,
+    .cRe = -0.76,
+    .cIm = -0.102,
+    .kRe = -0.5,
+    .kIm = 0.65,
+    .power = 3
+  };
+  double zoom = 1;
+  unsigned repeat = 1;
+  int cache_mb = 0;   // off, so that repeats time the kernels
+  const char* store = NULL;
+  bool verify = false;
+  const char* output = "mandelbrot.ppm";
+  const char* centre = NULL;
+  const char* palette_spec = NULL;
+  double period = PALETTE_PERIOD;
+  uint32_t resume_from = 0;   // 0 to compute at the limit directly
+  bool adaptive = false;
+  bool limit_given = false;
+  unsigned antialias = 0;     // samples per side, 0 for off
+
+  static const struct option options[] = {
+    {"fractal", required_argument, NULL, 'f'},
+    {"power", required_argument, NULL, 'p'},
+    {"numeric", required_argument, NULL, 'n'},
+    {"center", required_argument, NULL, 'c'},
+    {"fixed-format", required_argument, NULL, 'F'},
+    {"zoom", required_argument, NULL, 'z'},
+    {"size", required_argument, NULL, 's'},
+    {"iterations", required_argument, NULL, 'i'},
+    {"julia-constant", required_argument, NULL, 'k'},
+    {"threads", required_argument, NULL, 't'},
+    {"simd", required_argument, NULL, 'v'},
+    {"no-interior", no_argument, NULL, 'I'},
+    {"series", no_argument, NULL, 'S'},
+    {"mode", required_argument, NULL, 'm'},
+    {"verify", no_argument, NULL, 'V'},
+    {"repeat", required_argument, NULL, 'r'},
+    {"cache", required_argument, NULL, 'C'},
+    {"store", required_argument, NULL, 'T'},
+    {"palette", required_argument, NULL, 'P'},
+    {"period", required_argument, NULL, 'Q'},
+    {"resume-from", required_argument, NULL, 'R'},
+    {"adaptive", no_argument, NULL, 'A'},
+    {"antialias", required_argument, NULL, 'a'},
+    {"output", required_argument, NULL, 'o'},
+    {"help", no_argument, NULL, 'h'},
+    {NULL, 0, NULL, 0}
+  };
+
+  int opt;
+  while((opt = getopt_long(argc, argv, "f:p:n:c:F:z:s:i:k:t:v:ISm:Vr:C:T:P:Q:R:Aa:o:h",
+                           options, NULL)) != -1)
+  {
+    bool ok = true;
+    switch(opt)
+    {
+      case 'f':
+        if(strcmp(optarg, "mandelbrot") == 0)
+          view.fractal = FRACTAL_MANDELBROT;
+        else if(strcmp(optarg, "julia") == 0)
+          view.fractal = FRACTAL_JULIA;
+        else if(strcmp(optarg, "burning-ship") == 0)
+          view.fractal = FRACTAL_BURNING_SHIP;
+        else if(strcmp(optarg, "multibrot") == 0)
+          view.fractal = FRACTAL_MULTIBROT;
+        else
+          ok = false;
+        break;
+      case 'p':
+        view.power = atoi(optarg);
+        ok = view.power == 3 || view.power == 4;
+        break;
+      case 'n':
+        if(strcmp(optarg, "double") == 0)
+          view.numeric = NUMERIC_DOUBLE;
+        else if(strcmp(optarg, "float") == 0)
+          view.numeric = NUMERIC_FLOAT;
+        else if(strcmp(optarg, "fixed") == 0)
+          view.numeric = NUMERIC_FIXED;
+        else if(strcmp(optarg, "perturbation") == 0)
+          view.numeric = NUMERIC_PERTURBATION;
+        else
+          ok = false;
+        break;
+      case 'c':
+        centre = optarg;
+        ok = parsePair(optarg, &view.cRe, &view.cIm) == 0;
+        break;
+      case 'F':
+        ok = parseFixedFormat(optarg) >= 0;
+        if(ok)
+          setFixedFormat(parseFixedFormat(optarg));
+        break;
+      case 'z':
+        zoom = atof(optarg);
+        ok = zoom > 0;
+        break;
+      case 's':
+        ok = sscanf(optarg, "%ux%u", &view.width, &view.height) == 2
+             && view.width > 0 && view.height > 0;
+        break;
+      case 'i':
+        ok = parseIterations(optarg) > 0;
+        if(ok)
+          view.MaxIterations = parseIterations(optarg);
+        limit_given = true;
+        break;
+      case 'k':
+        ok = parsePair(optarg, &view.kRe, &view.kIm) == 0;
+        break;
+      case 't':
+        ok = atoi(optarg) > 0;
+        if(ok)
+          setRenderThreads(atoi(optarg));
+        break;
+      case 'v':
+        ok = parseSimdLevel(optarg) >= 0;
+        if(ok)
+          setRenderSimd(parseSimdLevel(optarg));
+        break;
+      case 'I':
+        setInteriorDetection(false);
+        break;
+      case 'S':
+        setSeriesApproximation(true);
+        break;
+      case 'm':
+        if(strcmp(optarg, "brute") == 0)
+          setRenderMode(RENDER_BRUTE_FORCE);
+        else if(strcmp(optarg, "mariani-silver") == 0)
+          setRenderMode(RENDER_MARIANI_SILVER);
+        else if(strcmp(optarg, "progressive") == 0)
+          setRenderMode(RENDER_PROGRESSIVE);
+        else
+          ok = false;
+        break;
+      case 'V':
+        verify = true;
+        break;
+      case 'r':
+        repeat = atoi(optarg);
+        ok = repeat > 0;
+        break;
+      case 'C':
+        cache_mb = atoi(optarg);
+        ok = cache_mb >= 0;
+        break;
+      case 'T':
+        store = optarg;
+        break;
+      case 'P':
+        palette_spec = optarg;
+        break;
+      case 'Q':
+        period = atof(optarg);
+        ok = period > 0;
+        break;
+      case 'R':
+        ok = parseIterations(optarg) > 0;
+        if(ok)
+          resume_from = parseIterations(optarg);
+        break;
+      case 'A':
+        adaptive = true;
+        break;
+      case 'a':
+        antialias = atoi(optarg);
+        ok = antialias >= 2 && antialias <= ANTIALIAS_MAX_GRID;
+        break;
+      case 'o':
+        output = optarg;
+        break;
+      default:
+        ok = false;
+        break;
+    } // switch
+
+    if(!ok)
+    {
+      usage(argv[0]);
+      return opt == 'h' ? 0 : 1;
+    }
+  } // while
+
+  // deep views need every digit of the centre, not just a double's worth
+  if(centre != NULL && view.numeric != NUMERIC_DOUBLE)
+  {
+    char* re = strdup(centre);
+    char* im = strchr(re, ',');
+    *im++ = '\0';
+    int parsed = setDeepCentre(&view, re, im);
+    free(re);
+    if(parsed != 0)
+    {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  view.step = zoomToStep(zoom, view.height);
+  setTileCacheBudget((size_t)cache_mb << 20);
+  if(setTileStore(store) != 0)
+  {
+    fprintf(stderr, "%s: not a tile store or can't be opened\n", store);
+    return 1;
+  }
+
+  palette_t palette;
+  if(palette_spec != NULL && choosePalette(&palette, palette_spec) != 0)
+  {
+    fprintf(stderr, "%s: no such palette or not a palette file\n",
+            palette_spec);
+    return 1;
+  }
+  palette.period = period;
+
+  if(resume_from > 0 && !resumableView(&view))
+  {
+    fprintf(stderr, "--resume-from needs a double, float or 4.29 view\n");
+    return 1;
+  }
+  if(resume_from > 0 && adaptive)
+  {
+    fprintf(stderr, "--resume-from and --adaptive can't be combined\n");
+    return 1;
+  }
+
+  iteration_budget_t budget;
+  defaultIterationBudget(&budget);
+  if(limit_given)
+    budget.max_iterations = view.MaxIterations;
+  unsigned rounds = 0;
+
+  size_t count = (size_t)view.width * view.height;
+  uint32_t* iterations = malloc(count * sizeof(uint32_t));
+  uint32_t* pixels = malloc(count * sizeof(uint32_t));
+  float* magnitudes = NULL;
+  if(palette_spec != NULL)
+    magnitudes = malloc(count * sizeof(float));
+  escape_state_t* states = NULL;
+  if(resume_from > 0 || adaptive)
+    states = malloc(count * sizeof(escape_state_t));
+  if(iterations == NULL || pixels == NULL
+     || (palette_spec != NULL && magnitudes == NULL)
+     || ((resume_from > 0 || adaptive) && states == NULL))
+  {
+    perror("Could not allocate framebuffer");
+    return 1;
+  }
+  view_t lower = view;
+  lower.MaxIterations = resume_from;
+
+  double colour_time = 0;
+  double antialias_time = 0;
+  size_t refined = 0;
+  double elapsed = 0;
+  for(unsigned i = 0; i < repeat; i++)
+  {
+    // only carrying the frame on is timed, not computing it at first
+    if(resume_from > 0)
+      computeRegionResumable(&lower, iterations, magnitudes, states, 0, 0,
+                             view.width, view.height);
+    double start = now();
+    if(adaptive)
+      rounds = computeIterationsAdaptive(&budget, &view, iterations,
+                                         magnitudes, states);
+    else if(resume_from > 0)
+      resumeIterations(&view, resume_from, iterations, magnitudes, states,
+                       0, 0, view.width, view.height);
+    else
+      computeIterationsSmooth(&view, iterations, magnitudes);
+
+    double coloured = now();
+    if(magnitudes != NULL)
+      colourSmooth(&view, iterations, magnitudes, &palette, pixels);
+    else
+      colourIterations(&view, iterations, pixels);
+    colour_time += now() - coloured;
+    if(antialias > 0)
+    {
+      double refining = now();
+      refined = antialiasFrame(&view, iterations,
+                               magnitudes != NULL ? &palette : NULL,
+                               antialias, pixels);
+      antialias_time += now() - refining;
+    }
+    elapsed += now() - start;
+  } // for
+  elapsed /= repeat;
+
+  fprintf(stderr, "%ux%u, %u iterations, %u threads, %s: %.3f ms/frame, "
+          "%.2f Mpixel/s\n", view.width, view.height, view.MaxIterations,
+          renderThreads(), simdLevelName(renderSimd()), elapsed * 1e3,
+          count / elapsed * 1e-6);
+
+  if(magnitudes != NULL)
+    fprintf(stderr, "smooth colouring: %.3f ms/frame\n",
+            colour_time / repeat * 1e3);
+
+  if(antialias > 0)
+    fprintf(stderr, "antialiasing: %zu pixels refined (%.1f%%) with %ux%u "
+            "samples, %.3f ms/frame\n", refined, 100.0 * refined / count,
+            antialias, antialias, antialias_time / repeat * 1e3);
+
+  if(adaptive)
+    fprintf(stderr, "adaptive limit: %u iterations after %u rounds, "
+            "starting from %u at this zoom\n", view.MaxIterations, rounds,
+            zoomIterations(&budget, &view));
+
+  if(resume_from > 0)
+    fprintf(stderr, "resumed from %u iterations: %lu pixels iterated "
+            "further (%.1f%%)\n", resume_from, renderResumedPixels(),
+            100.0 * renderResumedPixels() / count);
+
+  if(view.numeric == NUMERIC_FIXED)
+    fprintf(stderr, "fixed point: %s\n",
+            fixedFormatName(viewFixedFormat(&view)));
+
+  if(renderMode() == RENDER_MARIANI_SILVER)
+    fprintf(stderr, "subdivision filled %lu pixels (%.1f%%)\n",
+            renderFilledPixels(), 100.0 * renderFilledPixels() / count);
+
+  if(cache_mb > 0)
+  {
+    tile_cache_stats_t stats = renderTileCacheStats();
+    fprintf(stderr, "tile cache: %lu hits, %lu misses, %zu tiles in %.1f "
+            "MiB\n", stats.hits, stats.misses, stats.tiles,
+            stats.bytes / 1048576.0);
+  }
+
+  if(store != NULL)
+  {
+    tile_store_stats_t stats = renderTileStoreStats();
+    fprintf(stderr, "tile store: %lu hits, %lu misses, %lu tiles written, "
+            "%lu tiles in %.1f MiB\n", stats.hits, stats.misses,
+            stats.written, stats.tiles, stats.bytes / 1048576.0);
+  }
+
+  if(view.numeric == NUMERIC_PERTURBATION)
+    fprintf(stderr, "perturbation: %u-bit reference orbit, %lu pixels "
+            "rebased (%.1f%%)\n", (bigfixLimbsFor(view.step) - 1) * 64,
+            renderRebasedPixels(), 100.0 * renderRebasedPixels() / count);
+
+  if(view.numeric == NUMERIC_PERTURBATION && seriesApproximation())
+  {
+    double total = 0;
+    for(size_t i = 0; i < count; i++)
+      total += iterations[i];
+    fprintf(stderr, "series approximation: skipped %u iterations per pixel "
+            "(%.1f%% of all iterations)\n", renderSeriesSkip(),
+            total > 0 ? 100.0 * renderSeriesSkip() * count / total : 0);
+  }
+
+  if(writeImage(output, pixels, view.width, view.height) != 0)
+  {
+    perror(output);
+    return 1;
+  }
+
+  int status = 0;
+  if(verify)
+  {
+    uint32_t* reference = malloc(count * sizeof(uint32_t));
+    if(reference == NULL)
+    {
+      perror("Could not allocate reference buffer");
+      return 1;
+    }
+
+    render_mode_t mode = renderMode();
+    setRenderMode(RENDER_BRUTE_FORCE);
+    setTileCacheBudget(0);  // the reference must be iterated
+    setTileStore(NULL);
+    computeIterations(&view, reference);
+    setRenderMode(mode);
+
+    size_t mismatches = 0;
+    for(size_t i = 0; i < count; i++)
+      if(reference[i] != iterations[i])
+        mismatches++;
+
+    fprintf(stderr, "verify: %zu of %zu pixels differ from brute force "
+            "(%.4f%%)\n", mismatches, count, 100.0 * mismatches / count);
+    free(reference);
+    status = mismatches == 0 ? 0 : 2;
+  }
+
+  free(iterations);
+  free(pixels);
+  free(magnitudes);
+  free(states);
+  return status;
+}
@@ -0,0 +1,421 @@
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "render_sw.h"
+#include "image_sw.h"
+
+/*
+  Slippy-map tile pyramid: renders every 256x256 tile of levels z0..z1 that
+  overlaps a bounding box and writes it to DIR/z/x/y.png. Level 0 is one
+  tile covering the world square, every level halves the step, x counts
+  columns from the left and y rows from the top.
+
+  The pyramid is walked depth first, so only one tile of counts per level
+  is held at a time and tiles go to disk as soon as they are coloured. A
+  child's pixels at even x and y lie exactly on pixels of its parent; when
+  the level's coordinates are computed without rounding (see
+  exactChildLevel) those are copied and only the other three quarters are
+  iterated. Each tile is computed by all render threads.
+*/
+
+#define TILE_EDGE 256
+// Pans of the deepest level still fit view_t's 32 bits
+#define MAX_LEVEL 22
+
+typedef struct
+{
+  view_t world;         // fractal, number format, limit and world centre
+  double size;          // edge of the square level 0 covers
+  double min_re, min_im, max_re, max_im;  // bounding box
+  unsigned z0, z1;
+  bool reuse;
+  bool verify;
+  const char* output;
+  uint32_t* counts[MAX_LEVEL + 1];
+  uint32_t* pixels;
+  uint32_t* reference;  // --verify only
+
+  unsigned long tiles;
+  unsigned long reused;     // pixels copied from a parent tile
+  unsigned long mismatches; // reused tiles differing from brute force
+} pyramid_t;
+
+static void usage(const char* program)
+{
+  fprintf(stderr,
+    "Usage: %s [options]\n"
+    "  -f, --fractal mandelbrot|julia|burning-ship|multibrot\n"
+    "                                   fractal to render (mandelbrot)\n"
+    "  -p, --power 3|4                  multibrot exponent (3)\n"
+    "  -n, --numeric double|float|fixed|perturbation\n"
+    "                                   number format (double)\n"
+    "  -F, --fixed-format auto|4.29|4.60|4.124\n"
+    "                                   fixed-point format (auto)\n"
+    "  -i, --iterations N               maximum iterations (50)\n"
+    "  -k, --julia-constant RE,IM       Julia constant (-0.5,0.65)\n"
+    "  -w, --world RE,IM,SIZE           centre and edge of level 0\n"
+    "                                   (-0.5,0,4; 0,0,4 for Julia)\n"
+    "  -b, --bbox RE0,IM0,RE1,IM1       only tiles overlapping this box\n"
+    "                                   (the whole world)\n"
+    "  -l, --levels Z0-Z1               levels to render (0-4), at most %d\n"
+    "  -R, --no-reuse                   iterate every pixel of every level\n"
+    "  -V, --verify                     compare reused tiles against brute\n"
+    "                                   force\n"
+    "  -t, --threads N                  render threads (all CPUs)\n"
+    "  -v, --simd scalar|avx2|avx512    vector kernel (widest supported)\n"
+    "  -o, --output DIR                 root of the z/x/y.png tree (tiles)\n",
+    program, MAX_LEVEL);
+}
+
+static double now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// View of tile (x, y) of level z: all tiles of a level share the world
+// centre and step and differ in the pan only, see view_t
+static view_t levelView(const pyramid_t* p, unsigned z, long x, long y)
+{
+  view_t view = p->world;
+  long half = (long)TILE_EDGE / 2 * ((1l << z) - 1);
+  view.width = TILE_EDGE;
+  view.height = TILE_EDGE;
+  view.step = p->size / ((double)TILE_EDGE * (1l << z));
+  view.panX = x * TILE_EDGE - half;
+  view.panY = y * TILE_EDGE - half;
+  return view;
+}
+
+// Tiles [*lo, *hi] of level z along one axis that overlap [from, to], an
+// axis starting at origin and counting tiles in direction sign
+static void tileRange(const pyramid_t* p, unsigned z, double origin,
+                      double sign, double from, double to, long* lo,
+                      long* hi)
+{
+  double edge = p->size / (1l << z);
+  double a = floor(sign * (from - origin) / edge);
+  double b = floor(sign * (to - origin) / edge);
+  long last = (1l << z) - 1;
+  *lo = fmax(fmin(a, b), 0);
+  *hi = fmin(fmax(a, b), last);
+}
+
+static bool overlaps(const pyramid_t* p, unsigned z, long x, long y)
+{
+  long x0, x1, y0, y1;
+  tileRange(p, z, p->world.cRe - p->size / 2, 1, p->min_re, p->max_re,
+            &x0, &x1);
+  tileRange(p, z, p->world.cIm + p->size / 2, -1, p->min_im, p->max_im,
+            &y0, &y1);
+  return x >= x0 && x <= x1 && y >= y0 && y <= y1;
+}
+
+/*
+  Whether the pixels of level z at even lattice positions get exactly the
+  coordinates of the level z - 1 pixels they lie on. In double that holds
+  when the centre is a multiple of the step and no coordinate needs more
+  than 53 bits of it: every sum and product the kernels form is then exact.
+  4.29 coordinates are integers and only need the parent's factor to be
+  twice the child's. Float, the wide formats and perturbation (one
+  reference orbit per tile) are recomputed.
+*/
+static bool exactChildLevel(const pyramid_t* p, unsigned z)
+{
+  view_t child = levelView(p, z, 0, 0);
+  view_t parent = levelView(p, z - 1, 0, 0);
+  double step = child.step;
+
+  if(child.numeric == NUMERIC_DOUBLE)
+  {
+    double extent = fmax(fabs(child.cRe), fabs(child.cIm)) + p->size;
+    return fmod(child.cRe, step) == 0 && fmod(child.cIm, step) == 0
+           && extent < ldexp(step, 53);
+  }
+  if(child.numeric == NUMERIC_FIXED)
+    return viewFixedFormat(&child) == FIXED_4_29
+           && viewFixedFormat(&parent) == FIXED_4_29
+           && floatToFixed(step) != 0
+           && floatToFixed(parent.step) == 2 * floatToFixed(step);
+  return false;
+}
+
+static int makeDirectory(const char* path)
+{
+  if(mkdir(path, 0755) == 0 || errno == EEXIST)
+    return 0;
+  perror(path);
+  return -1;
+}
+
+static int writeTile(pyramid_t* p, const view_t* view, unsigned z, long x,
+                     long y, const uint32_t* counts)
+{
+  char path[4096];
+  colourIterations(view, counts, p->pixels);
+
+  snprintf(path, sizeof(path), "%s/%u", p->output, z);
+  if(makeDirectory(path) != 0)
+    return -1;
+  snprintf(path, sizeof(path), "%s/%u/%ld", p->output, z, x);
+  if(makeDirectory(path) != 0)
+    return -1;
+  snprintf(path, sizeof(path), "%s/%u/%ld/%ld.png", p->output, z, x, y);
+  if(writeImage(path, p->pixels, TILE_EDGE, TILE_EDGE) != 0)
+  {
+    perror(path);
+    return -1;
+  }
+  p->tiles++;
+  return 0;
+}
+
+// Renders tile (x, y) of level z and the tiles below it. parent holds the
+// counts of the tile above, NULL if there is none or it can't be reused.
+static int renderTile(pyramid_t* p, unsigned z, long x, long y,
+                      const uint32_t* parent)
+{
+  view_t view = levelView(p, z, x, y);
+  uint32_t* counts = p->counts[z];
+
+  if(parent != NULL)
+  {
+    // the quarter of the parent this tile covers, spread out on its grid
+    // of spacing 2
+    const uint32_t* quarter = parent + (y % 2) * (TILE_EDGE / 2) * TILE_EDGE
+                              + (x % 2) * (TILE_EDGE / 2);
+    for(unsigned j = 0; j < TILE_EDGE / 2; j++)
+      for(unsigned i = 0; i < TILE_EDGE / 2; i++)
+        counts[2*j*TILE_EDGE + 2*i] = quarter[j*TILE_EDGE + i];
+    refineIterations(&view, counts, 2);
+    p->reused += TILE_EDGE * TILE_EDGE / 4;
+
+    if(p->verify)
+    {
+      computeIterations(&view, p->reference);
+      if(memcmp(p->reference, counts,
+                TILE_EDGE * TILE_EDGE * sizeof(uint32_t)) != 0)
+        p->mismatches++;
+    }
+  }
+  else
+  {
+    computeIterations(&view, counts);
+  }
+
+  if(writeTile(p, &view, z, x, y, counts) != 0)
+    return -1;
+  if(z == p->z1)
+    return 0;
+
+  bool reuse = p->reuse && exactChildLevel(p, z + 1);
+  for(long cy = 2*y; cy <= 2*y + 1; cy++)
+    for(long cx = 2*x; cx <= 2*x + 1; cx++)
+      if(overlaps(p, z + 1, cx, cy)
+         && renderTile(p, z + 1, cx, cy, reuse ? counts : NULL) != 0)
+        return -1;
+  return 0;
+}
+
+int main(int argc, char* argv[])
+{
+  pyramid_t p = {
+    .world = {
+      .fractal = FRACTAL_MANDELBROT,
+      .numeric = NUMERIC_DOUBLE,
+      .MaxIterations = 50,
+      .kRe = -0.5,
+      .kIm = 0.65,
+      .power = 3
+    },
+    .z0 = 0,
+    .z1 = 4,
+    .reuse = true,
+    .output = "tiles"
+  };
+  bool world = false, bbox = false;
+
+  static const struct option options[] = {
+    {"fractal", required_argument, NULL, 'f'},
+    {"power", required_argument, NULL, 'p'},
+    {"numeric", required_argument, NULL, 'n'},
+    {"fixed-format", required_argument, NULL, 'F'},
+    {"iterations", required_argument, NULL, 'i'},
+    {"julia-constant", required_argument, NULL, 'k'},
+    {"world", required_argument, NULL, 'w'},
+    {"bbox", required_argument, NULL, 'b'},
+    {"levels", required_argument, NULL, 'l'},
+    {"no-reuse", no_argument, NULL, 'R'},
+    {"verify", no_argument, NULL, 'V'},
+    {"threads", required_argument, NULL, 't'},
+    {"simd", required_argument, NULL, 'v'},
+    {"output", required_argument, NULL, 'o'},
+    {"help", no_argument, NULL, 'h'},
+    {NULL, 0, NULL, 0}
+  };
+
+  int opt;
+  while((opt = getopt_long(argc, argv, "f:p:n:F:i:k:w:b:l:RVt:v:o:h", options,
+                           NULL)) != -1)
+  {
+    bool ok = true;
+    switch(opt)
+    {
+      case 'f':
+        if(strcmp(optarg, "mandelbrot") == 0)
+          p.world.fractal = FRACTAL_MANDELBROT;
+        else if(strcmp(optarg, "julia") == 0)
+          p.world.fractal = FRACTAL_JULIA;
+        else if(strcmp(optarg, "burning-ship") == 0)
+          p.world.fractal = FRACTAL_BURNING_SHIP;
+        else if(strcmp(optarg, "multibrot") == 0)
+          p.world.fractal = FRACTAL_MULTIBROT;
+        else
+          ok = false;
+        break;
+      case 'p':
+        p.world.power = atoi(optarg);
+        ok = p.world.power == 3 || p.world.power == 4;
+        break;
+      case 'n':
+        if(strcmp(optarg, "double") == 0)
+          p.world.numeric = NUMERIC_DOUBLE;
+        else if(strcmp(optarg, "float") == 0)
+          p.world.numeric = NUMERIC_FLOAT;
+        else if(strcmp(optarg, "fixed") == 0)
+          p.world.numeric = NUMERIC_FIXED;
+        else if(strcmp(optarg, "perturbation") == 0)
+          p.world.numeric = NUMERIC_PERTURBATION;
+        else
+          ok = false;
+        break;
+      case 'F':
+        ok = parseFixedFormat(optarg) >= 0;
+        if(ok)
+          setFixedFormat(parseFixedFormat(optarg));
+        break;
+      case 'i':
+        ok = parseIterations(optarg) > 0;
+        if(ok)
+          p.world.MaxIterations = parseIterations(optarg);
+        break;
+      case 'k':
+        ok = sscanf(optarg, "%lf,%lf", &p.world.kRe, &p.world.kIm) == 2;
+        break;
+      case 'w':
+        world = true;
+        ok = sscanf(optarg, "%lf,%lf,%lf", &p.world.cRe, &p.world.cIm,
+                    &p.size) == 3 && p.size > 0;
+        break;
+      case 'b':
+        bbox = true;
+        ok = sscanf(optarg, "%lf,%lf,%lf,%lf", &p.min_re, &p.min_im,
+                    &p.max_re, &p.max_im) == 4;
+        break;
+      case 'l':
+      {
+        int levels = sscanf(optarg, "%u-%u", &p.z0, &p.z1);
+        if(levels == 1)
+          p.z1 = p.z0;
+        ok = levels >= 1 && p.z0 <= p.z1 && p.z1 <= MAX_LEVEL;
+        break;
+      }
+      case 'R':
+        p.reuse = false;
+        break;
+      case 'V':
+        p.verify = true;
+        break;
+      case 't':
+        ok = atoi(optarg) > 0;
+        if(ok)
+          setRenderThreads(atoi(optarg));
+        break;
+      case 'v':
+        ok = parseSimdLevel(optarg) >= 0;
+        if(ok)
+          setRenderSimd(parseSimdLevel(optarg));
+        break;
+      case 'o':
+        p.output = optarg;
+        break;
+      default:
+        ok = false;
+        break;
+    } // switch
+
+    if(!ok)
+    {
+      usage(argv[0]);
+      return opt == 'h' ? 0 : 1;
+    }
+  } // while
+
+  if(!world)
+  {
+    p.world.cRe = p.world.fractal == FRACTAL_JULIA ? 0 : -0.5;
+    p.world.cIm = 0;
+    p.size = 4;
+  }
+  if(!bbox)
+  {
+    p.min_re = p.world.cRe - p.size / 2;
+    p.max_re = p.world.cRe + p.size / 2;
+    p.min_im = p.world.cIm - p.size / 2;
+    p.max_im = p.world.cIm + p.size / 2;
+  }
+
+  // tiles are never revisited, a cache would only hold memory
+  setTileCacheBudget(0);
+
+  size_t tile_bytes = TILE_EDGE * TILE_EDGE * sizeof(uint32_t);
+  bool allocated = true;
+  for(unsigned z = p.z0; z <= p.z1; z++)
+    allocated = (p.counts[z] = malloc(tile_bytes)) != NULL && allocated;
+  p.pixels = malloc(tile_bytes);
+  p.reference = p.verify ? malloc(tile_bytes) : NULL;
+  if(!allocated || p.pixels == NULL || (p.verify && p.reference == NULL))
+  {
+    perror("Could not allocate tile buffers");
+    return 1;
+  }
+  if(makeDirectory(p.output) != 0)
+    return 1;
+
+  double start = now();
+  long x0, x1, y0, y1;
+  tileRange(&p, p.z0, p.world.cRe - p.size / 2, 1, p.min_re, p.max_re,
+            &x0, &x1);
+  tileRange(&p, p.z0, p.world.cIm + p.size / 2, -1, p.min_im, p.max_im,
+            &y0, &y1);
+  int status = 0;
+  for(long y = y0; y <= y1 && status == 0; y++)
+    for(long x = x0; x <= x1 && status == 0; x++)
+      status = renderTile(&p, p.z0, x, y, NULL);
+  double elapsed = now() - start;
+
+  double pixels = (double)p.tiles * TILE_EDGE * TILE_EDGE;
+  fprintf(stderr, "%lu tiles, levels %u-%u, %u iterations, %u threads: "
+          "%.3f s, %.1f tiles/s, %.1f%% of pixels reused from parents\n",
+          p.tiles, p.z0, p.z1, p.world.MaxIterations, renderThreads(),
+          elapsed, p.tiles / elapsed,
+          pixels > 0 ? 100.0 * p.reused / pixels : 0);
+  if(p.verify)
+    fprintf(stderr, "verify: %lu reused tiles differ from brute force\n",
+            p.mismatches);
+
+  for(unsigned z = p.z0; z <= p.z1; z++)
+    free(p.counts[z]);
+  free(p.pixels);
+  free(p.reference);
+  if(status != 0)
+    return 1;
+  return p.mismatches == 0 ? 0 : 2;
+}
@@ -1,4 +1,10 @@
+#include <math.h>
+
 #include "mandelbrot_sw.h"
+#include "framebuffer_sw.h"
+#include "render_sw.h"
+#include "render_thread_sw.h"
+#include "event_loop_sw.h"
 
 int createWindow(int width, int height)
 {
@@ -53,12 +59,6 @@ int buildColor(int red, int green, int blue)
         (((int)(blue)%256)));
 } 
 
-void drawPixel(int x, int y, int color)
-{
-  XSetForeground(dis, gc, color);
-  XDrawPoint(dis, win, gc, x, y);
-}
-
 void close_display()
 {
   XFreeGC(dis, gc);
@@ -67,65 +67,6 @@ void close_display()
   exit(1);
 }
 
-int mandelbrot(uint32_t ImageWidth, uint32_t ImageHeight, uint32_t MaxIterations, 
-               double cRe, double cIm, uint32_t zoom)
-{
-
-  double Re_factor = 0.01 / zoom;
-  double Im_factor = 0.01 / zoom;
-  
-  double MinRe = cRe - Re_factor*(ImageWidth/2);
-  double MinIm = cIm - Im_factor*(ImageHeight/2);
-
-  double MaxRe = MinRe + Re_factor*ImageWidth;
-  double MaxIm = MinIm + Im_factor*ImageHeight;
-
-  uint32_t colour_unit = (uint32_t)((1 << 24) / (MaxIterations));
-
-  for(unsigned y = 0; y < ImageHeight; y++)
-  {
-    double c_im = MaxIm - y*Im_factor;
-    for(unsigned x = 0; x < ImageWidth; x++)
-    {
-      double c_re = MinRe + x*Re_factor;
-
-      // Calculate whether c belongs to the Mandelbrot set or
-      // not and draw a pixel at coordinates (x,y) accordingly
-      double Z_re = c_re, Z_im = c_im; // Set Z = c
-      bool isInside = true;
-      unsigned n = 0;
-      
-      for(n = 0; n < MaxIterations; n++)
-      {
-        double Z_im2 = Z_im*Z_im;
-        double Z_re2 = Z_re*Z_re;
-        
-        if(Z_re2 + Z_im2 > 4) // |z| > 2
-        {
-          isInside = false;
-          break;
-        }
-        /*
-          N.B. Z^2 = (a + bi)^2 = (a^2 - b^2) + (2ab)i
-        */
-        
-        Z_im = 2*Z_re*Z_im + c_im;
-        Z_re = Z_re2 - Z_im2 + c_re;
-        
-      }
-      
-      if(isInside) 
-      { 
-        drawPixel(x, y, buildColor(0, 0, 0));
-      } // if
-      else
-      {
-        drawPixel(x, y, colour_unit * n);        
-      }
-    } // for
-  } // for
-} // mandelbrot()
-
 void main()
 {
   unsigned int ImageWidth = 500;
@@ -140,6 +81,47 @@ void main()
   {
     printf("created window\n");
     
+    framebuffer_t fb;
+    if(createFramebuffer(&fb, dis, ImageWidth, ImageHeight) == -1)
+      close_display();
+    
+    view_t view = {
+      .fractal = FRACTAL_MANDELBROT,
+      .numeric = NUMERIC_DOUBLE,
+      .width = ImageWidth,
+      .height = ImageHeight,
+      .MaxIterations = MaxIterations
+    };
+    // frames are computed in the background, so key presses are handled
+    // while a frame renders
+    render_thread_t* renderer = createRenderThread(ImageWidth, ImageHeight);
+    if(renderer == NULL)
+      close_display();
+    view_t shown = view;    // view of the frame on screen
+    
+    // the iteration limit follows the zoom and the escape counts until
+    // 'i', 'I' or 'l' fix it
+    iteration_budget_t budget;
+    defaultIterationBudget(&budget);
+    bool adaptive = true;
+    setRenderIterationBudget(renderer, &budget);
+    
+    unsigned antialias = 0;   // samples per side on edge pixels, 0 for off
+    
+    // 'p' cycles plain colouring and the built-in palettes; the palette
+    // $MANDELBROT_PALETTE names (built in or a file) is used from the start
+    palette_t palette;
+    int palette_index = -1;   // built-in palette shown, -1 for none
+    const char* palette_spec = getenv("MANDELBROT_PALETTE");
+    if(palette_spec != NULL && *palette_spec != '\0')
+    {
+      if(choosePalette(&palette, palette_spec) == 0)
+        setRenderPalette(renderer, &palette);
+      else
+        fprintf(stderr, "%s: no such palette or not a palette file\n",
+                palette_spec);
+    }
+    
 /*    XEvent ev;*/
     
     XEvent event;    /* the XEvent declaration !!! */
@@ -148,10 +130,22 @@ void main()
     
     bool quit = false;
     bool zoom_on = false;
+    bool dirty = true;      // view changed since the last frame
+    bool exposed = false;   // window needs the last frame presented again
     while (!quit) 
     {
-      if(XCheckWindowEvent(dis, win, KeyPressMask, &event))
+      // sleep until there is input or a finished frame
+      if(!dirty && !exposed)
+        waitForDisplay(dis, renderThreadFd(renderer), -1);
+      
+      // handle everything that has arrived, so that a burst of key
+      // presses is rendered as one frame
+      while(XPending(dis) > 0)
       {
+        XNextEvent(dis, &event);
+        if(event.type == Expose && event.xexpose.count == 0)
+          exposed = true;
+        
         if(event.type == KeyPress
            && XLookupString(&event.xkey, text, 255, &key, 0) == 1) 
         {
@@ -161,6 +155,9 @@ void main()
           if (text[0]=='q') 
             quit = true;
             
+          // pans snap to whole pixels so the last frame can be scrolled
+          long shift_pixels = lround(0.1 / (0.01 / zoom));
+
           switch(text[0])
           {
             // quit
@@ -171,42 +168,124 @@ void main()
             case 'z': 
               zoom_on = !zoom_on;
               break;
+            // cycle brute force / Mariani-Silver / progressive
+            case 'm': 
+              setRenderMode(renderMode() == RENDER_BRUTE_FORCE
+                            ? RENDER_MARIANI_SILVER
+                            : renderMode() == RENDER_MARIANI_SILVER
+                            ? RENDER_PROGRESSIVE : RENDER_BRUTE_FORCE);
+              break;
+            // cycle plain colouring and the smooth palettes, a frame is
+            // recoloured without iterating it again
+            case 'p':
+              palette_index++;
+              if(paletteName(palette_index) == NULL)
+                palette_index = -1;
+              else
+                generatePalette(&palette, paletteName(palette_index));
+              setRenderPalette(renderer, palette_index >= 0 ? &palette
+                                                            : NULL);
+              break;
+            // double / halve the iteration limit, starting from the one on
+            // screen if it was adapting; pixels that hit the old limit
+            // carry on from where they stopped rather than starting over
+            case 'i':
+            case 'I':
+              if(adaptive)
+              {
+                adaptive = false;
+                view.MaxIterations = shown.MaxIterations;
+                setRenderIterationBudget(renderer, NULL);
+              }
+              // the vector kernels keep counts in 32-bit lanes
+              if(text[0] == 'i'
+                 && view.MaxIterations <= BUDGET_MAX_ITERATIONS / 2)
+                view.MaxIterations *= 2;
+              else if(text[0] == 'I' && view.MaxIterations > 1)
+                view.MaxIterations /= 2;
+              break;
+            // adapt the iteration limit, or keep the one on screen
+            case 'l':
+              adaptive = !adaptive;
+              view.MaxIterations = shown.MaxIterations;
+              setRenderIterationBudget(renderer, adaptive ? &budget : NULL);
+              break;
+            // cycle antialiasing off / 2x2 / 4x4
+            case 'x':
+              antialias = antialias == 0 ? 2 : antialias == 2 ? 4 : 0;
+              setRenderAntialias(renderer, antialias);
+              break;
             // reset
             case 'r': 
               zoom = 1;
               zoom_on = false;
+              view.MaxIterations = MaxIterations;
+              adaptive = true;
+              setRenderIterationBudget(renderer, &budget);
               
               cRe = -1.25;
               cIm = -0.18;
+              view.panX = 0;
+              view.panY = 0;
               break;
             // Move left and right  
             case 'a':
-              cRe -= 0.1;
+              view.panX -= shift_pixels;
               break;
             case 'd':
-              cRe += 0.1;
+              view.panX += shift_pixels;
               break;
             case 'w':
-              cIm += 0.1;
+              view.panY -= shift_pixels;
               break;
             case 's': 
-              cIm -= 0.1;
+              view.panY += shift_pixels;
               break;
               
             default:
-              break;
+              continue; // not a command, nothing to redraw
           } // switch
+          dirty = true;
         } // if key press
-      } // if
+      } // while events
       
-      // continue drawing otherwise
-      mandelbrot(ImageWidth, ImageHeight, MaxIterations, cRe, cIm, zoom);
+      if(dirty)
+      {
+        view.cRe = cRe;
+        view.cIm = cIm;
+        view.step = 0.01 / zoom;
+        requestRender(renderer, &view);
+        dirty = false;
+      }
       
-      if(zoom_on)
-        zoom++;
+      bool complete;
+      if(takeFrame(renderer, fb.pixels, &shown, &complete))
+      {
+        exposed = true;
+        
+        // auto zoom asks for the next frame once one is on screen, not
+        // just a progressive preview of it
+        if(zoom_on && complete)
+        {
+          // the pan is counted in pixels of the step just rendered
+          recentreView(&view);
+          cRe = view.cRe;
+          cIm = view.cIm;
+          zoom++;
+          dirty = true;
+        }
+      }
+      
+      if(exposed)
+      {
+        presentFramebuffer(&fb, win, gc, 0, 0);
+        exposed = false;
+      }
       
     } // while
     
+    destroyRenderThread(renderer);
+    destroyFramebuffer(&fb);
     close_display();
   } // if
   else
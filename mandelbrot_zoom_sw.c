@@ -0,0 +1,429 @@
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "render_sw.h"
+
+/*
+  Offline zoom sequence: renders a fixed number of frames zooming
+  exponentially from one zoom to another into a target point, and writes
+  them to stdout as raw RGB24 for an encoder, e.g.
+
+    ./mandelbrot_zoom_sw.out --frames 600 --end-zoom 1e6 \
+      | ffmpeg -f rawvideo -pix_fmt rgb24 -s 800x800 -r 30 -i - zoom.mp4
+
+  A writer thread converts and writes frame N while frame N + 1 is
+  computed. With --reproject K only every Kth frame is computed; the frames
+  in between are resampled from the last computed one, which covers them
+  completely as the zoom only goes in.
+*/
+
+typedef struct
+{
+  pthread_mutex_t lock;
+  pthread_cond_t changed;
+  uint32_t* frames[2];  // pixels, filled alternately by the render loop
+  bool full[2];         // frame waiting to be written
+  bool done;            // no more frames will come
+  bool failed;          // a write failed, stop rendering
+  uint32_t width;
+  uint32_t height;
+} writer_t;
+
+static void usage(const char* program)
+{
+  fprintf(stderr,
+    "Usage: %s [options] > frames.rgb\n"
+    "  -f, --fractal mandelbrot|julia|burning-ship|multibrot\n"
+    "                                   fractal to render (mandelbrot)\n"
+    "  -p, --power 3|4                  multibrot exponent (3)\n"
+    "  -n, --numeric double|float|fixed|perturbation\n"
+    "                                   number format (double)\n"
+    "  -c, --center RE,IM               target point (-0.743643887037151,\n"
+    "                                   0.131825904205330), to any number\n"
+    "                                   of digits but with double\n"
+    "  -F, --fixed-format auto|4.29|4.60|4.124\n"
+    "                                   fixed-point format (auto)\n"
+    "  -Z, --start-zoom Z               zoom of the first frame (1)\n"
+    "  -z, --end-zoom Z                 zoom of the last frame (1e4)\n"
+    "  -N, --frames N                   number of frames (300)\n"
+    "  -s, --size WxH                   frame size (800x800)\n"
+    "  -i, --iterations N               maximum iterations (500)\n"
+    "  -k, --julia-constant RE,IM       Julia constant (-0.5,0.65)\n"
+    "  -t, --threads N                  render threads (all CPUs)\n"
+    "  -v, --simd scalar|avx2|avx512    vector kernel (widest supported)\n"
+    "  -S, --series                     skip iterations with a series\n"
+    "                                   approximation (perturbation only)\n"
+    "  -r, --reproject K                compute every Kth frame, resample\n"
+    "                                   the others (1, compute all)\n",
+    program);
+}
+
+static int parsePair(const char* text, double* a, double* b)
+{
+  return sscanf(text, "%lf,%lf", a, b) == 2 ? 0 : -1;
+}
+
+static double now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void* writeFrames(void* context)
+{
+  writer_t* writer = context;
+  size_t count = (size_t)writer->width * writer->height;
+  unsigned char* rgb = malloc(count * 3);
+
+  for(unsigned frame = 0;; frame++)
+  {
+    unsigned slot = frame % 2;
+    pthread_mutex_lock(&writer->lock);
+    while(!writer->full[slot] && !writer->done)
+      pthread_cond_wait(&writer->changed, &writer->lock);
+    bool last = !writer->full[slot];
+    pthread_mutex_unlock(&writer->lock);
+    if(last)
+      break;
+
+    const uint32_t* pixels = writer->frames[slot];
+    bool written = rgb != NULL;
+    if(written)
+    {
+      for(size_t i = 0; i < count; i++)
+      {
+        rgb[3*i] = pixels[i] >> 16;
+        rgb[3*i + 1] = pixels[i] >> 8;
+        rgb[3*i + 2] = pixels[i];
+      }
+      written = fwrite(rgb, 3, count, stdout) == count;
+    }
+
+    pthread_mutex_lock(&writer->lock);
+    writer->full[slot] = false;
+    writer->failed = writer->failed || !written;
+    pthread_cond_broadcast(&writer->changed);
+    pthread_mutex_unlock(&writer->lock);
+  } // for
+
+  free(rgb);
+  fflush(stdout);
+  return NULL;
+}
+
+// Waits until the writer is done with the frame buffer of slot, returns
+// NULL if writing failed
+static uint32_t* freeFrame(writer_t* writer, unsigned slot)
+{
+  pthread_mutex_lock(&writer->lock);
+  while(writer->full[slot] && !writer->failed)
+    pthread_cond_wait(&writer->changed, &writer->lock);
+  bool failed = writer->failed;
+  pthread_mutex_unlock(&writer->lock);
+  return failed ? NULL : writer->frames[slot];
+}
+
+static void queueFrame(writer_t* writer, unsigned slot)
+{
+  pthread_mutex_lock(&writer->lock);
+  writer->full[slot] = true;
+  pthread_cond_broadcast(&writer->changed);
+  pthread_mutex_unlock(&writer->lock);
+}
+
+// Channel c (bit shift) of a bilinear blend of four pixels
+static uint32_t blendChannel(uint32_t p00, uint32_t p10, uint32_t p01,
+                             uint32_t p11, double fx, double fy, int c)
+{
+  double top = ((p00 >> c) & 0xff) * (1 - fx) + ((p10 >> c) & 0xff) * fx;
+  double bottom = ((p01 >> c) & 0xff) * (1 - fx) + ((p11 >> c) & 0xff) * fx;
+  return (uint32_t)(top * (1 - fy) + bottom * fy + 0.5) << c;
+}
+
+// Frame at step ratio times that of key, around the same centre, resampled
+// from key; ratio is at most 1 so every pixel falls inside key
+static void reprojectFrame(const uint32_t* key, uint32_t* pixels,
+                           uint32_t width, uint32_t height, double ratio)
+{
+  // pixel x sits (x - width/2) steps from the centre, see setupViewport()
+  double half_x = width / 2, half_y = height / 2;
+
+  for(uint32_t y = 0; y < height; y++)
+  {
+    double ky = half_y + (y - half_y) * ratio;
+    uint32_t y0 = (uint32_t)ky;
+    uint32_t y1 = y0 + 1 < height ? y0 + 1 : y0;
+    double fy = ky - y0;
+    const uint32_t* row0 = key + (size_t)y0*width;
+    const uint32_t* row1 = key + (size_t)y1*width;
+
+    for(uint32_t x = 0; x < width; x++)
+    {
+      double kx = half_x + (x - half_x) * ratio;
+      uint32_t x0 = (uint32_t)kx;
+      uint32_t x1 = x0 + 1 < width ? x0 + 1 : x0;
+      double fx = kx - x0;
+      pixels[(size_t)y*width + x] =
+        blendChannel(row0[x0], row0[x1], row1[x0], row1[x1], fx, fy, 16)
+        | blendChannel(row0[x0], row0[x1], row1[x0], row1[x1], fx, fy, 8)
+        | blendChannel(row0[x0], row0[x1], row1[x0], row1[x1], fx, fy, 0);
+    }
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  view_t view = {
+    .fractal = FRACTAL_MANDELBROT,
+    .numeric = NUMERIC_DOUBLE,
+    .width = 800,
+    .height = 800,
+    .MaxIterations = 500,
+    .cRe = -0.743643887037151,
+    .cIm = 0.131825904205330,
+    .kRe = -0.5,
+    .kIm = 0.65,
+    .power = 3
+  };
+  double start_zoom = 1, end_zoom = 1e4;
+  unsigned frames = 300;
+  unsigned reproject = 1;
+  const char* centre = NULL;
+
+  static const struct option options[] = {
+    {"fractal", required_argument, NULL, 'f'},
+    {"power", required_argument, NULL, 'p'},
+    {"numeric", required_argument, NULL, 'n'},
+    {"center", required_argument, NULL, 'c'},
+    {"fixed-format", required_argument, NULL, 'F'},
+    {"start-zoom", required_argument, NULL, 'Z'},
+    {"end-zoom", required_argument, NULL, 'z'},
+    {"frames", required_argument, NULL, 'N'},
+    {"size", required_argument, NULL, 's'},
+    {"iterations", required_argument, NULL, 'i'},
+    {"julia-constant", required_argument, NULL, 'k'},
+    {"threads", required_argument, NULL, 't'},
+    {"simd", required_argument, NULL, 'v'},
+    {"series", no_argument, NULL, 'S'},
+    {"reproject", required_argument, NULL, 'r'},
+    {"help", no_argument, NULL, 'h'},
+    {NULL, 0, NULL, 0}
+  };
+
+  int opt;
+  while((opt = getopt_long(argc, argv, "f:p:n:c:F:Z:z:N:s:i:k:t:v:Sr:h",
+                           options, NULL)) != -1)
+  {
+    bool ok = true;
+    switch(opt)
+    {
+      case 'f':
+        if(strcmp(optarg, "mandelbrot") == 0)
+          view.fractal = FRACTAL_MANDELBROT;
+        else if(strcmp(optarg, "julia") == 0)
+          view.fractal = FRACTAL_JULIA;
+        else if(strcmp(optarg, "burning-ship") == 0)
+          view.fractal = FRACTAL_BURNING_SHIP;
+        else if(strcmp(optarg, "multibrot") == 0)
+          view.fractal = FRACTAL_MULTIBROT;
+        else
+          ok = false;
+        break;
+      case 'p':
+        view.power = atoi(optarg);
+        ok = view.power == 3 || view.power == 4;
+        break;
+      case 'n':
+        if(strcmp(optarg, "double") == 0)
+          view.numeric = NUMERIC_DOUBLE;
+        else if(strcmp(optarg, "float") == 0)
+          view.numeric = NUMERIC_FLOAT;
+        else if(strcmp(optarg, "fixed") == 0)
+          view.numeric = NUMERIC_FIXED;
+        else if(strcmp(optarg, "perturbation") == 0)
+          view.numeric = NUMERIC_PERTURBATION;
+        else
+          ok = false;
+        break;
+      case 'c':
+        centre = optarg;
+        ok = parsePair(optarg, &view.cRe, &view.cIm) == 0;
+        break;
+      case 'F':
+        ok = parseFixedFormat(optarg) >= 0;
+        if(ok)
+          setFixedFormat(parseFixedFormat(optarg));
+        break;
+      case 'Z':
+        start_zoom = atof(optarg);
+        ok = start_zoom > 0;
+        break;
+      case 'z':
+        end_zoom = atof(optarg);
+        ok = end_zoom > 0;
+        break;
+      case 'N':
+        frames = atoi(optarg);
+        ok = frames > 0;
+        break;
+      case 's':
+        ok = sscanf(optarg, "%ux%u", &view.width, &view.height) == 2
+             && view.width > 0 && view.height > 0;
+        break;
+      case 'i':
+        ok = parseIterations(optarg) > 0;
+        if(ok)
+          view.MaxIterations = parseIterations(optarg);
+        break;
+      case 'k':
+        ok = parsePair(optarg, &view.kRe, &view.kIm) == 0;
+        break;
+      case 't':
+        ok = atoi(optarg) > 0;
+        if(ok)
+          setRenderThreads(atoi(optarg));
+        break;
+      case 'v':
+        ok = parseSimdLevel(optarg) >= 0;
+        if(ok)
+          setRenderSimd(parseSimdLevel(optarg));
+        break;
+      case 'S':
+        setSeriesApproximation(true);
+        break;
+      case 'r':
+        reproject = atoi(optarg);
+        ok = reproject > 0;
+        break;
+      default:
+        ok = false;
+        break;
+    } // switch
+
+    if(!ok)
+    {
+      usage(argv[0]);
+      return opt == 'h' ? 0 : 1;
+    }
+  } // while
+
+  // reprojected frames are cut from a shallower one
+  if(end_zoom < start_zoom)
+  {
+    fprintf(stderr, "%s: the end zoom must not be below the start zoom\n",
+            argv[0]);
+    return 1;
+  }
+
+  if(isatty(STDOUT_FILENO))
+  {
+    fprintf(stderr, "%s: refusing to write raw frames to a terminal\n",
+            argv[0]);
+    usage(argv[0]);
+    return 1;
+  }
+
+  if(centre != NULL && view.numeric != NUMERIC_DOUBLE)
+  {
+    char* re = strdup(centre);
+    char* im = strchr(re, ',');
+    *im++ = '\0';
+    int parsed = setDeepCentre(&view, re, im);
+    free(re);
+    if(parsed != 0)
+    {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  // no frame repeats a plane, a cache would only cost the copies
+  setTileCacheBudget(0);
+
+  size_t count = (size_t)view.width * view.height;
+  writer_t writer = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .changed = PTHREAD_COND_INITIALIZER,
+    .frames = {malloc(count * sizeof(uint32_t)),
+               malloc(count * sizeof(uint32_t))},
+    .width = view.width,
+    .height = view.height
+  };
+  uint32_t* iterations = malloc(count * sizeof(uint32_t));
+  uint32_t* key = malloc(count * sizeof(uint32_t));
+  if(writer.frames[0] == NULL || writer.frames[1] == NULL
+     || iterations == NULL || key == NULL)
+  {
+    perror("Could not allocate frame buffers");
+    return 1;
+  }
+
+  pthread_t thread;
+  if(pthread_create(&thread, NULL, writeFrames, &writer) != 0)
+  {
+    perror("Could not start the writer thread");
+    return 1;
+  }
+
+  double start = now(), compute = 0;
+  double key_step = 0;
+  unsigned computed = 0;
+  for(unsigned frame = 0; frame < frames; frame++)
+  {
+    uint32_t* pixels = freeFrame(&writer, frame % 2);
+    if(pixels == NULL)
+      break;
+
+    // equal ratios between frames, the last one at end_zoom exactly
+    double t = frames > 1 ? (double)frame / (frames - 1) : 0;
+    double zoom = start_zoom * pow(end_zoom / start_zoom, t);
+    view.step = zoomToStep(zoom, view.height);
+
+    double frame_start = now();
+    if(frame % reproject == 0)
+    {
+      renderView(&view, iterations, pixels);
+      memcpy(key, pixels, count * sizeof(uint32_t));
+      key_step = view.step;
+      computed++;
+    }
+    else
+    {
+      reprojectFrame(key, pixels, view.width, view.height,
+                     view.step / key_step);
+    }
+    compute += now() - frame_start;
+    queueFrame(&writer, frame % 2);
+  } // for
+
+  pthread_mutex_lock(&writer.lock);
+  writer.done = true;
+  pthread_cond_broadcast(&writer.changed);
+  pthread_mutex_unlock(&writer.lock);
+  pthread_join(thread, NULL);
+  double elapsed = now() - start;
+
+  if(writer.failed)
+  {
+    perror("Could not write frames");
+    return 1;
+  }
+  fprintf(stderr, "%u frames of %ux%u (%u computed, %u reprojected), zoom "
+          "%g to %g, %u threads: %.3f s, %.1f frames/s, %.1f%% of the time "
+          "computing\n", frames, view.width, view.height, computed,
+          frames - computed, start_zoom, end_zoom, renderThreads(), elapsed,
+          frames / elapsed, 100.0 * compute / elapsed);
+
+  free(writer.frames[0]);
+  free(writer.frames[1]);
+  free(iterations);
+  free(key);
+  return 0;
+}
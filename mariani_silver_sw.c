@@ -0,0 +1,127 @@
+#include <math.h>
+#include <stddef.h>
+
+#include "render_internal_sw.h"
+
+/*
+  Mariani-Silver rectangle subdivision. Only rectangle borders are iterated;
+  a rectangle whose whole border has the same iteration count is filled
+  with that count, otherwise it is split in two along its longer side and
+  the dividing line is iterated. Small mixed rectangles are iterated pixel
+  by pixel. Coordinates below are inclusive and the border of a rectangle
+  is always computed before the rectangle is visited.
+*/
+
+// Rectangles with an edge at most this long are iterated pixel by pixel
+#define MARIANI_SILVER_MIN_SIZE 4
+
+typedef struct
+{
+  const view_t* view;
+  const viewport_t* vp;
+  uint32_t* iterations;
+} subdivision_t;
+
+static inline uint32_t* rowAt(const subdivision_t* s, unsigned y)
+{
+  return s->iterations + (size_t)y*s->view->width;
+}
+
+static void iterateColumn(const subdivision_t* s, unsigned x,
+                          unsigned y0, unsigned y1)
+{
+  iterateColumnSpan(s->view, s->vp, x, y0, y1 + 1, s->iterations);
+}
+
+static bool uniformBorder(const subdivision_t* s, unsigned x0, unsigned y0,
+                          unsigned x1, unsigned y1)
+{
+  uint32_t n = rowAt(s, y0)[x0];
+  const uint32_t* top = rowAt(s, y0);
+  const uint32_t* bottom = rowAt(s, y1);
+
+  for(unsigned x = x0; x <= x1; x++)
+    if(top[x] != n || bottom[x] != n)
+      return false;
+
+  for(unsigned y = y0 + 1; y < y1; y++)
+  {
+    const uint32_t* row = rowAt(s, y);
+    if(row[x0] != n || row[x1] != n)
+      return false;
+  }
+  return true;
+}
+
+static unsigned long subdivide(const subdivision_t* s, unsigned x0,
+                               unsigned y0, unsigned x1, unsigned y1)
+{
+  // no pixels strictly inside the border
+  if(x1 - x0 < 2 || y1 - y0 < 2)
+    return 0;
+
+  if(uniformBorder(s, x0, y0, x1, y1))
+  {
+    uint32_t n = rowAt(s, y0)[x0];
+    float* magnitudes = s->vp->magnitudes;
+    escape_state_t* states = s->vp->states;
+    size_t width = s->view->width;
+    for(unsigned y = y0 + 1; y < y1; y++)
+    {
+      uint32_t* row = rowAt(s, y);
+      for(unsigned x = x0 + 1; x < x1; x++)
+        row[x] = n;
+      if(magnitudes != NULL)
+        for(unsigned x = x0 + 1; x < x1; x++)
+          magnitudes[y*width + x] = magnitudes[y0*width + x0];
+      // no orbit to carry on from, see escape_state_t
+      if(states != NULL)
+        for(unsigned x = x0 + 1; x < x1; x++)
+          states[y*width + x] = (escape_state_t){INFINITY, INFINITY};
+    }
+    return (unsigned long)(x1 - x0 - 1) * (y1 - y0 - 1);
+  }
+
+  if(x1 - x0 <= MARIANI_SILVER_MIN_SIZE || y1 - y0 <= MARIANI_SILVER_MIN_SIZE)
+  {
+    for(unsigned y = y0 + 1; y < y1; y++)
+      iterateSpan(s->view, s->vp, y, x0 + 1, x1, rowAt(s, y));
+    return 0;
+  }
+
+  if(x1 - x0 >= y1 - y0)
+  {
+    unsigned xm = (x0 + x1) / 2;
+    iterateColumn(s, xm, y0 + 1, y1 - 1);
+    return subdivide(s, x0, y0, xm, y1) + subdivide(s, xm, y0, x1, y1);
+  }
+  else
+  {
+    unsigned ym = (y0 + y1) / 2;
+    iterateSpan(s->view, s->vp, ym, x0 + 1, x1, rowAt(s, ym));
+    return subdivide(s, x0, y0, x1, ym) + subdivide(s, x0, ym, x1, y1);
+  }
+}
+
+unsigned long computeTileMarianiSilver(const view_t* view,
+                                       const viewport_t* vp,
+                                       uint32_t* iterations,
+                                       unsigned x0, unsigned y0,
+                                       unsigned x1, unsigned y1)
+{
+  subdivision_t s = {view, vp, iterations};
+  unsigned xe = x1 - 1, ye = y1 - 1;
+
+  // outer border of the tile
+  iterateSpan(view, vp, y0, x0, x1, rowAt(&s, y0));
+  if(ye > y0)
+    iterateSpan(view, vp, ye, x0, x1, rowAt(&s, ye));
+  if(ye > y0 + 1)
+  {
+    iterateColumn(&s, x0, y0 + 1, ye - 1);
+    if(xe > x0)
+      iterateColumn(&s, xe, y0 + 1, ye - 1);
+  }
+
+  return subdivide(&s, x0, y0, xe, ye);
+}
@@ -0,0 +1,182 @@
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "palette_sw.h"
+
+// The colouring loop has a run-time trip count, which the -O2 cost model
+// won't vectorise
+#pragma GCC optimize ("vect-cost-model=cheap")
+
+// Colour stops a palette file may have
+#define PALETTE_MAX_STOPS 256
+
+typedef struct
+{
+  const char* name;
+  unsigned count;
+  uint32_t stops[8];
+} gradient_t;
+
+static const gradient_t gradients[] = {
+  // deep blue through white to orange, the usual escape-time look
+  {"ultra", 5, {0x000764, 0x206bcb, 0xedffff, 0xffaa00, 0x000200}},
+  {"fire", 5, {0x000000, 0x900000, 0xff5000, 0xffd000, 0xffffc0}},
+  {"ocean", 6, {0x001020, 0x004080, 0x00a0c0, 0x90ffff, 0x00a0c0,
+                0x004080}},
+  {"grey", 2, {0x000000, 0xffffff}},
+  {"rainbow", 6, {0xff0000, 0xffff00, 0x00ff00, 0x00ffff, 0x0000ff,
+                  0xff00ff}}
+};
+
+#define GRADIENTS (sizeof(gradients) / sizeof(gradients[0]))
+
+// Linear blend of one 8-bit channel at shift, t in [0, 1]
+static uint32_t blendChannel(uint32_t a, uint32_t b, double t, int shift)
+{
+  double from = (a >> shift) & 0xff, to = (b >> shift) & 0xff;
+  return (uint32_t)(from + (to - from) * t + 0.5) << shift;
+}
+
+// Spreads count stops evenly over the table, each blending into the next
+// and the last into the first
+static void fillPalette(palette_t* palette, const uint32_t* stops,
+                        unsigned count)
+{
+  for(unsigned i = 0; i < PALETTE_SIZE; i++)
+  {
+    double position = (double)i * count / PALETTE_SIZE;
+    unsigned stop = (unsigned)position;
+    double t = position - stop;
+    uint32_t a = stops[stop], b = stops[(stop + 1) % count];
+    palette->colours[i] = blendChannel(a, b, t, 16) | blendChannel(a, b, t, 8)
+                          | blendChannel(a, b, t, 0);
+  }
+  palette->period = PALETTE_PERIOD;
+}
+
+const char* paletteName(unsigned index)
+{
+  return index < GRADIENTS ? gradients[index].name : NULL;
+}
+
+int generatePalette(palette_t* palette, const char* name)
+{
+  for(unsigned i = 0; i < GRADIENTS; i++)
+    if(strcmp(name, gradients[i].name) == 0)
+    {
+      fillPalette(palette, gradients[i].stops, gradients[i].count);
+      return 0;
+    }
+  return -1;
+}
+
+int loadPalette(palette_t* palette, const char* path)
+{
+  FILE* file = fopen(path, "r");
+  if(file == NULL)
+    return -1;
+
+  uint32_t stops[PALETTE_MAX_STOPS];
+  unsigned count = 0;
+  bool ok = true;
+  char line[256];
+  while(ok && fgets(line, sizeof(line), file) != NULL)
+  {
+    char* text = line;
+    while(isspace((unsigned char)*text))
+      text++;
+    if(*text == '\0' || *text == ';')
+      continue;
+    if(*text == '#')
+      text++;
+
+    char* end;
+    unsigned long colour = strtoul(text, &end, 16);
+    long digits = end - text;
+    while(isspace((unsigned char)*end))
+      end++;
+    ok = digits == 6 && *end == '\0' && count < PALETTE_MAX_STOPS;
+    if(ok)
+      stops[count++] = colour;
+  } // while
+  fclose(file);
+
+  if(!ok || count == 0)
+    return -1;
+  fillPalette(palette, stops, count);
+  return 0;
+}
+
+int choosePalette(palette_t* palette, const char* spec)
+{
+  if(generatePalette(palette, spec) == 0)
+    return 0;
+  return loadPalette(palette, spec);
+}
+
+// log2 of a positive normal x to about 1e-3 from its exponent bits and a
+// polynomial in the mantissa that is exact at both ends of the octave, so
+// the result is continuous. Plain arithmetic, so colourSmooth vectorises.
+static inline float fastLog2(float x)
+{
+  uint32_t bits;
+  memcpy(&bits, &x, sizeof(bits));
+  float exponent = (float)((int32_t)(bits >> 23) - 127);
+  bits = (bits & 0x007fffff) | 0x3f800000;
+  float t;
+  memcpy(&t, &bits, sizeof(t));
+  t -= 1;   // mantissa - 1, in [0, 1)
+  return exponent + t + t*(1 - t)*(0.42086454f - 0.15638611f*t);
+}
+
+// Bit patterns of 4.0f and 2^100, the |z|^2 range colourSmooth works in
+#define R2_MIN_BITS 0x40800000
+#define R2_MAX_BITS 0x71800000
+
+// restrict spares the vector loop a run-time overlap check
+void colourSmooth(const view_t* view, const uint32_t* restrict iterations,
+                  const float* restrict magnitudes, const palette_t* palette,
+                  uint32_t* restrict pixels)
+{
+  uint32_t MaxIterations = view->MaxIterations;
+  size_t count = (size_t)view->width * view->height;
+  float power = view->fractal == FRACTAL_MULTIBROT ? view->power : 2;
+  float log_power = 1 / fastLog2(power);
+  // palette entries per iteration in 16.16 fixed point; positions wrap
+  // around in 32 bits, which PALETTE_SIZE << 16 divides
+  uint32_t step = (uint32_t)(PALETTE_SIZE * 65536.0 / palette->period
+                             + 0.5);
+
+  // palette indices first, with the PALETTE_SIZE bit set for inside points:
+  // without a gather instruction only this part vectorises
+  for(size_t i = 0; i < count; i++)
+  {
+    uint32_t n = iterations[i];
+    // escaped pixels have |z|^2 > 4; inside ones may hold anything, NaN
+    // included. Clamped as integers, which order non-negative floats like
+    // the floats and put negative ones below, so the loop has no branch.
+    int32_t bits;
+    memcpy(&bits, &magnitudes[i], sizeof(bits));
+    bits = bits > R2_MIN_BITS ? bits : R2_MIN_BITS;
+    bits = bits < R2_MAX_BITS ? bits : R2_MAX_BITS;
+    float r2;
+    memcpy(&r2, &bits, sizeof(r2));
+    // log2(log|z| / log 2) = log2(log2(|z|^2) / 2)
+    float fraction = 1 - fastLog2(fastLog2(r2) * 0.5f) * log_power;
+    uint32_t position = n*step + (uint32_t)(int32_t)(fraction * step);
+    uint32_t index = (position >> 16) & (PALETTE_SIZE - 1);
+    // a mask rather than a choice, or the logs would be skipped for inside
+    // points with a branch
+    uint32_t inside = -(uint32_t)isInsideCount(n, MaxIterations);
+    pixels[i] = index | (inside & PALETTE_SIZE);
+  }
+
+  for(size_t i = 0; i < count; i++)
+  {
+    uint32_t index = pixels[i];
+    pixels[i] = index < PALETTE_SIZE ? palette->colours[index] : 0;
+  }
+}
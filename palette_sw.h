@@ -0,0 +1,52 @@
+#ifndef PALETTE_SW_H
+#define PALETTE_SW_H
+
+#include <stdint.h>
+
+#include "render_sw.h"
+
+/*
+  Smooth colouring. A palette is one cycle of PALETTE_SIZE colours,
+  interpolated from a handful of colour stops when it is built, so
+  colouring a pixel is a table lookup; palettes come from the built-in
+  gradients or from a file. The colouring pass reads the counts and the
+  |z|^2 that computeIterationsSmooth() leaves, nothing else.
+*/
+
+// Entries of one cycle, a power of two so that indices wrap with a mask
+#define PALETTE_SIZE 1024
+// Iterations one cycle spans unless the caller sets another period
+#define PALETTE_PERIOD 32
+
+typedef struct
+{
+  uint32_t colours[PALETTE_SIZE];   // 0x00RRGGBB
+  float period;                     // iterations per cycle
+} palette_t;
+
+// Name of the built-in gradient index, NULL past the last one
+const char* paletteName(unsigned index);
+
+// Fills palette with the built-in gradient name. Returns -1 if there is
+// none of that name.
+int generatePalette(palette_t* palette, const char* name);
+
+// Reads a palette file: one colour stop per line, as RRGGBB in hex with or
+// without a leading '#'; blank lines and lines starting with ';' are
+// skipped. The stops are spaced evenly and the last one blends back into
+// the first. Returns -1 if the file can't be read or has no stops.
+int loadPalette(palette_t* palette, const char* path);
+
+// The built-in gradient spec if there is one, else the file at that path
+int choosePalette(palette_t* palette, const char* spec);
+
+// Smooth colouring: an escaped pixel is coloured by its normalised count
+// n + 1 - log_d(log|z| / log 2) for z^d + c, looked up in the palette at
+// PALETTE_SIZE / period entries per iteration; inside points are black.
+// Only the two buffers are read, so recolouring a frame or switching
+// palettes costs one pass over them instead of iterating again.
+void colourSmooth(const view_t* view, const uint32_t* iterations,
+                  const float* magnitudes, const palette_t* palette,
+                  uint32_t* pixels);
+
+#endif // PALETTE_SW_H
@@ -0,0 +1,437 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "render_internal_sw.h"
+
+/*
+  Perturbation rendering for zooms beyond double precision. One reference
+  orbit X_n is iterated at the view centre in multi-limb fixed point
+  (bigfix_sw.h) and stored as doubles. Every pixel then only iterates its
+  small difference d_n = z_n - X_n in double precision:
+
+    d_{n+1} = 2 X_n d_n + d_n^2 + dc
+
+  where dc is the pixel's offset from the centre (0 for Julia sets). Doubles
+  have the exponent range for offsets far below 1e-100, so the per-pixel
+  cost stays that of the double path.
+
+  A pixel glitches when its orbit comes closer to the start of the reference
+  orbit than to the reference itself: d_n is then larger than z_n and its
+  rounding swamps the result. Such pixels, and pixels that outlive an
+  escaping reference, are rebased (Zhuoran's method): d becomes
+  z_n - X_0 and iteration continues from the start of the orbit, which
+  represents the same z exactly.
+
+  Interior detection is not used here: the cardioid test and cycle
+  detection need the pixel's coordinates, which a double can't hold.
+
+  At deep zoom every pixel spends its first iterations close to the
+  reference, where d_n is a smooth function of dc. The series approximation
+  tracks d_n ~ A_n dc + B_n dc^2 + C_n dc^3 alongside the orbit and lets
+  every pixel start at the last iteration where the cubic term is still
+  negligible, no pixel of the frame can have escaped or glitched, and the
+  series agrees with probe pixels iterated in full.
+*/
+
+// The cubic term may grow to this fraction of the linear one
+#define SERIES_TOLERANCE 1e-12
+// Largest relative error of a probe's series offset against iterating it
+#define SERIES_PROBE_TOLERANCE 1e-9
+// Corners and edge midpoints of the frame
+#define SERIES_PROBES 8
+
+struct reference_orbit
+{
+  // what the orbit was computed for
+  fractal_t fractal;
+  uint32_t MaxIterations;
+  unsigned limbs;
+  bigfix_t c_re, c_im;        // exact view centre
+  double k_re, k_im;
+
+  // X_0 .. X_length, length >= 1; X_length escaped or it is the last point
+  // a pixel of MaxIterations iterations can reach
+  unsigned length;
+  double* re;
+  double* im;
+  unsigned generation;        // changes whenever the orbit is recomputed
+};
+
+// Only computeRegion() asks for orbits and series, and its calls never
+// overlap
+static reference_orbit_t reference;
+
+static struct
+{
+  unsigned generation;
+  double step;
+  uint32_t width, height;
+  int32_t panX, panY;
+  series_t series;
+} series_cache;
+
+static void exactCentre(const view_t* view, bigfix_t* c_re, bigfix_t* c_im)
+{
+  bigfixFromDouble(c_re, view->cRe);
+  bigfixFromDouble(c_im, view->cIm);
+  bigfixAdd(c_re, c_re, &view->deepRe, BIGFIX_LIMBS);
+  bigfixAdd(c_im, c_im, &view->deepIm, BIGFIX_LIMBS);
+}
+
+static bool orbitMatches(const view_t* view, unsigned limbs,
+                         const bigfix_t* c_re, const bigfix_t* c_im)
+{
+  bool julia = view->fractal == FRACTAL_JULIA;
+  return reference.re != NULL && reference.fractal == view->fractal
+         && reference.MaxIterations == view->MaxIterations
+         && reference.limbs == limbs
+         && memcmp(&reference.c_re, c_re, sizeof(bigfix_t)) == 0
+         && memcmp(&reference.c_im, c_im, sizeof(bigfix_t)) == 0
+         && (!julia || (reference.k_re == view->kRe
+                        && reference.k_im == view->kIm));
+}
+
+const reference_orbit_t* referenceOrbit(const view_t* view)
+{
+  unsigned limbs = bigfixLimbsFor(view->step);
+  bigfix_t c_re, c_im;
+  exactCentre(view, &c_re, &c_im);
+
+  // pans and recolouring keep the centre, so the orbit is usually reused
+  if(orbitMatches(view, limbs, &c_re, &c_im))
+    return &reference;
+
+  // a Mandelbrot pixel starts at X_1 = c and may run MaxIterations more
+  unsigned last = view->MaxIterations + 1;
+  free(reference.re);
+  free(reference.im);
+  reference.re = malloc((last + 1) * sizeof(double));
+  reference.im = malloc((last + 1) * sizeof(double));
+  if(reference.re == NULL || reference.im == NULL)
+  {
+    free(reference.re);
+    free(reference.im);
+    reference.re = reference.im = NULL;
+    return NULL;
+  }
+
+  bool julia = view->fractal == FRACTAL_JULIA;
+  bigfix_t k_re, k_im, Z_re, Z_im;
+  if(julia)
+  {
+    bigfixFromDouble(&k_re, view->kRe);
+    bigfixFromDouble(&k_im, view->kIm);
+    Z_re = c_re;
+    Z_im = c_im;
+  }
+  else
+  {
+    k_re = c_re;
+    k_im = c_im;
+    memset(&Z_re, 0, sizeof(Z_re));
+    memset(&Z_im, 0, sizeof(Z_im));
+  }
+
+  unsigned n;
+  for(n = 0; n <= last; n++)
+  {
+    double re = bigfixToDouble(&Z_re), im = bigfixToDouble(&Z_im);
+    reference.re[n] = re;
+    reference.im[n] = im;
+    // a rebase steps from X_0, so X_1 is kept even if X_0 escaped
+    if(n == last || (n > 0 && re*re + im*im > 4))
+      break;
+
+    // Z = Z^2 + k, Z^2 = (a^2 - b^2) + (2ab)i
+    bigfix_t Z_re2, Z_im2, Z_reim;
+    bigfixMul(&Z_re2, &Z_re, &Z_re, limbs);
+    bigfixMul(&Z_im2, &Z_im, &Z_im, limbs);
+    bigfixMul(&Z_reim, &Z_re, &Z_im, limbs);
+    bigfixSub(&Z_re, &Z_re2, &Z_im2, limbs);
+    bigfixAdd(&Z_re, &Z_re, &k_re, limbs);
+    bigfixAdd(&Z_im, &Z_reim, &Z_reim, limbs);
+    bigfixAdd(&Z_im, &Z_im, &k_im, limbs);
+  }
+
+  reference.fractal = view->fractal;
+  reference.MaxIterations = view->MaxIterations;
+  reference.limbs = limbs;
+  reference.c_re = c_re;
+  reference.c_im = c_im;
+  reference.k_re = view->kRe;
+  reference.k_im = view->kIm;
+  reference.length = n;
+  // 0 stays free for the empty series cache
+  if(++reference.generation == 0)
+    reference.generation = 1;
+  return &reference;
+}
+
+// Pixel offsets from the centre as the double path lays pixels out
+static void pixelOffset(const view_t* view, long x_at, long y_at,
+                        double* dc_re, double* dc_im)
+{
+  long half_width = view->width/2;
+  long half_height = view->height - view->height/2;
+  *dc_re = (x_at - half_width)*view->step;
+  *dc_im = (half_height - y_at)*view->step;
+}
+
+static void seriesStep(series_t* s, double x_re, double x_im, bool julia)
+{
+  // A' = 2XA + 1 (2XA for Julia sets), B' = 2XB + A^2, C' = 2XC + 2AB
+  double A_re = 2*(x_re*s->A_re - x_im*s->A_im) + (julia ? 0 : 1);
+  double A_im = 2*(x_re*s->A_im + x_im*s->A_re);
+  double B_re = 2*(x_re*s->B_re - x_im*s->B_im)
+                + s->A_re*s->A_re - s->A_im*s->A_im;
+  double B_im = 2*(x_re*s->B_im + x_im*s->B_re) + 2*s->A_re*s->A_im;
+  double C_re = 2*(x_re*s->C_re - x_im*s->C_im)
+                + 2*(s->A_re*s->B_re - s->A_im*s->B_im);
+  double C_im = 2*(x_re*s->C_im + x_im*s->C_re)
+                + 2*(s->A_re*s->B_im + s->A_im*s->B_re);
+
+  s->A_re = A_re;
+  s->A_im = A_im;
+  s->B_re = B_re;
+  s->B_im = B_im;
+  s->C_re = C_re;
+  s->C_im = C_im;
+  s->skip++;
+}
+
+static void seriesOffset(const series_t* s, double dc_re, double dc_im,
+                         double* d_re, double* d_im)
+{
+  // ((C dc + B) dc + A) dc
+  double t_re = s->C_re*dc_re - s->C_im*dc_im + s->B_re;
+  double t_im = s->C_re*dc_im + s->C_im*dc_re + s->B_im;
+  double u_re = t_re*dc_re - t_im*dc_im + s->A_re;
+  double u_im = t_re*dc_im + t_im*dc_re + s->A_im;
+  *d_re = u_re*dc_re - u_im*dc_im;
+  *d_im = u_re*dc_im + u_im*dc_re;
+}
+
+static void seriesAt(const reference_orbit_t* orbit, unsigned start,
+                     bool julia, unsigned skip, series_t* s)
+{
+  memset(s, 0, sizeof(*s));
+  s->A_re = 1;
+  while(s->skip < skip)
+    seriesStep(s, orbit->re[start + s->skip], orbit->im[start + s->skip],
+               julia);
+}
+
+// Iterations the series stays accurate for offsets up to radius, without
+// any such pixel escaping or meeting the rebase condition
+static unsigned seriesLength(const reference_orbit_t* orbit, unsigned start,
+                             bool julia, double radius, unsigned limit)
+{
+  series_t s;
+  seriesAt(orbit, start, julia, 0, &s);
+  double r = radius, r2 = r*r, r3 = r2*r;
+
+  for(unsigned m = start; m < orbit->length && s.skip < limit; m++)
+  {
+    double x_re = orbit->re[m], x_im = orbit->im[m];
+    double bound = hypot(s.A_re, s.A_im)*r + hypot(s.B_re, s.B_im)*r2
+                   + hypot(s.C_re, s.C_im)*r3;
+    if(hypot(x_re, x_im) + bound > 2)
+      break;
+    if(m > 0 && 2*bound > hypot(x_re - orbit->re[0], x_im - orbit->im[0]))
+      break;
+
+    series_t next = s;
+    seriesStep(&next, x_re, x_im, julia);
+    if(hypot(next.C_re, next.C_im)*r3
+       > SERIES_TOLERANCE*hypot(next.A_re, next.A_im)*r)
+      break;
+    s = next;
+  }
+  return s.skip;
+}
+
+// Iterates a probe's offset like iterateLinePerturbation() but without
+// rebasing, leaving the offset reached in d. Returns the iterations done,
+// fewer than skip if it escaped or needed a rebase earlier.
+static unsigned iterateProbe(const reference_orbit_t* orbit, unsigned start,
+                             bool julia, double dc_re, double dc_im,
+                             unsigned skip, double* d_re, double* d_im)
+{
+  const double* X_re = orbit->re;
+  const double* X_im = orbit->im;
+  double a_re = dc_re, a_im = dc_im;
+  if(julia)
+    dc_re = dc_im = 0;
+
+  unsigned j = 0;
+  for(; j < skip; j++)
+  {
+    unsigned m = start + j;
+    double z_re = X_re[m] + a_re, z_im = X_im[m] + a_im;
+    double w_re = z_re - X_re[0], w_im = z_im - X_im[0];
+    if(z_re*z_re + z_im*z_im > 4
+       || (m > 0 && w_re*w_re + w_im*w_im < a_re*a_re + a_im*a_im))
+      break;
+
+    double next_re = 2*(X_re[m]*a_re - X_im[m]*a_im) + a_re*a_re - a_im*a_im
+                     + dc_re;
+    a_im = 2*(X_re[m]*a_im + X_im[m]*a_re) + 2*a_re*a_im + dc_im;
+    a_re = next_re;
+  }
+  *d_re = a_re;
+  *d_im = a_im;
+  return j;
+}
+
+void approximateSeries(const view_t* view, const reference_orbit_t* orbit,
+                       series_t* series)
+{
+  if(series_cache.generation == orbit->generation
+     && series_cache.step == view->step
+     && series_cache.width == view->width
+     && series_cache.height == view->height
+     && series_cache.panX == view->panX && series_cache.panY == view->panY)
+  {
+    *series = series_cache.series;
+    return;
+  }
+
+  bool julia = view->fractal == FRACTAL_JULIA;
+  unsigned start = julia ? 0 : 1;
+
+  // the panned frame's corners and edge midpoints; the corners are the
+  // pixels furthest from the reference
+  long x_at[3] = {view->panX, view->panX + view->width/2,
+                  view->panX + (long)view->width - 1};
+  long y_at[3] = {view->panY, view->panY + view->height/2,
+                  view->panY + (long)view->height - 1};
+  double probe_re[SERIES_PROBES], probe_im[SERIES_PROBES];
+  double radius = 0;
+  unsigned probes = 0;
+  for(unsigned i = 0; i < 9; i++)
+  {
+    if(i == 4)
+      continue;
+    pixelOffset(view, x_at[i % 3], y_at[i / 3], &probe_re[probes],
+                &probe_im[probes]);
+    radius = fmax(radius, hypot(probe_re[probes], probe_im[probes]));
+    probes++;
+  }
+
+  unsigned skip = seriesLength(orbit, start, julia, radius,
+                               view->MaxIterations);
+
+  // shorten the series until every probe agrees with it
+  while(skip > 0)
+  {
+    seriesAt(orbit, start, julia, skip, series);
+    unsigned valid = skip;
+    for(unsigned i = 0; i < probes && valid == skip; i++)
+    {
+      double d_re, d_im, s_re, s_im;
+      valid = iterateProbe(orbit, start, julia, probe_re[i], probe_im[i],
+                           skip, &d_re, &d_im);
+      if(valid < skip)
+        break;
+      seriesOffset(series, probe_re[i], probe_im[i], &s_re, &s_im);
+      if(hypot(s_re - d_re, s_im - d_im)
+         > SERIES_PROBE_TOLERANCE*hypot(d_re, d_im))
+        valid = skip / 2;
+    }
+    if(valid == skip)
+      break;
+    skip = valid;
+  }
+  if(skip == 0)
+    seriesAt(orbit, start, julia, 0, series);
+
+  series_cache.generation = orbit->generation;
+  series_cache.step = view->step;
+  series_cache.width = view->width;
+  series_cache.height = view->height;
+  series_cache.panX = view->panX;
+  series_cache.panY = view->panY;
+  series_cache.series = *series;
+}
+
+void iterateLinePerturbation(const view_t* view, const viewport_t* vp,
+                             bool column, unsigned line, unsigned t0,
+                             unsigned t1, unsigned stride, unsigned shift,
+                             uint32_t* out, float* magnitude,
+                             escape_state_t* state)
+{
+  uint32_t MaxIterations = view->MaxIterations;
+  bool julia = view->fractal == FRACTAL_JULIA;
+  const reference_orbit_t* orbit = vp->orbit;
+  if(orbit == NULL)
+  {
+    memset(out, 0, (t1 - t0) * sizeof(uint32_t));
+    if(magnitude != NULL)
+      memset(magnitude, 0, (t1 - t0) * sizeof(float));
+    return;
+  }
+  const double* X_re = orbit->re;
+  const double* X_im = orbit->im;
+
+  long line_at = (long)line + (column ? view->panX : view->panY);
+  int32_t offset = (column ? view->panY : view->panX) + shift;
+  const series_t* series = &vp->series;
+  unsigned long rebased = 0;
+
+  for(unsigned t = t0; t < t1; t++)
+  {
+    long t_at = (long)t*stride + offset;
+    long x_at = column ? line_at : t_at;
+    long y_at = column ? t_at : line_at;
+    double dc_re, dc_im;
+    pixelOffset(view, x_at, y_at, &dc_re, &dc_im);
+
+    // z_0 = c: Mandelbrot pixels start at X_1 = c, Julia pixels at X_0
+    double d_re = dc_re, d_im = dc_im;
+    unsigned m = julia ? 0 : 1;
+    unsigned n = 0;
+    if(series->skip != 0)
+    {
+      seriesOffset(series, dc_re, dc_im, &d_re, &d_im);
+      m += series->skip;
+      n = series->skip;
+    }
+    if(julia)
+      dc_re = dc_im = 0;
+    bool glitched = false;
+    double r2 = 0;
+
+    for(; n < MaxIterations; n++)
+    {
+      double z_re = X_re[m] + d_re, z_im = X_im[m] + d_im;
+      r2 = z_re*z_re + z_im*z_im;
+      if(r2 > 4) // |z| > 2
+        break;
+
+      double w_re = z_re - X_re[0], w_im = z_im - X_im[0];
+      if(m == orbit->length
+         || w_re*w_re + w_im*w_im < d_re*d_re + d_im*d_im)
+      {
+        d_re = w_re;
+        d_im = w_im;
+        m = 0;
+        glitched = true;
+      }
+
+      double x_re = X_re[m], x_im = X_im[m];
+      double next_re = 2*(x_re*d_re - x_im*d_im) + d_re*d_re - d_im*d_im
+                       + dc_re;
+      d_im = 2*(x_re*d_im + x_im*d_re) + 2*d_re*d_im + dc_im;
+      d_re = next_re;
+      m++;
+    }
+    out[t - t0] = n;
+    if(magnitude != NULL)
+      magnitude[t - t0] = r2;
+    rebased += glitched;
+  } // for
+
+  if(rebased != 0)
+    __atomic_fetch_add(vp->rebased, rebased, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,131 @@
+#ifndef RENDER_INTERNAL_SW_H
+#define RENDER_INTERNAL_SW_H
+
+#include "render_sw.h"
+
+// Shared between the render core and its alternative tile renderers
+
+typedef struct reference_orbit reference_orbit_t;
+
+// Perturbation offset of every pixel after skip iterations, approximated
+// by the series d = A dc + B dc^2 + C dc^3 in the pixel's offset dc
+typedef struct
+{
+  unsigned skip;
+  double A_re, A_im;
+  double B_re, B_im;
+  double C_re, C_im;
+} series_t;
+
+typedef struct viewport viewport_t;
+
+// Pixels [t0, t1) of row `line`, or of column `line` when column is set,
+// written to out[0..t1 - t0), |z|^2 where each one stopped iterating to
+// magnitude[0..t1 - t0) and their escape state to state[0..t1 - t0),
+// either unless it is NULL. Pixel t is at t*stride + shift on the line.
+typedef void (*escape_line_fn)(const view_t* view, const viewport_t* vp,
+                               bool column, unsigned line, unsigned t0,
+                               unsigned t1, unsigned stride, unsigned shift,
+                               uint32_t* out, float* magnitude,
+                               escape_state_t* state);
+
+// Pixels xs[0..count) of row y carried on from their escape state state[x]
+// after out[x] iterations to view->MaxIterations; out[x], magnitude[x]
+// (unless magnitude is NULL) and state[x] are updated in place
+typedef void (*escape_resume_fn)(const view_t* view, const viewport_t* vp,
+                                 unsigned y, const unsigned* xs,
+                                 unsigned count, uint32_t* out,
+                                 float* magnitude, escape_state_t* state);
+
+// Formula a kernel iterates, the fractal with its power resolved
+typedef enum
+{
+  KERNEL_MANDELBROT,
+  KERNEL_JULIA,
+  KERNEL_BURNING_SHIP,
+  KERNEL_MULTIBROT3,
+  KERNEL_MULTIBROT4,
+  KERNEL_KINDS
+} kernel_kind_t;
+
+// MaxIterations all programs start with; every scalar kernel has a copy
+// compiled for this limit
+#define ESCAPE_CONSTANT_LIMIT 50
+
+// Coordinates of the image corner and pixel spacing in the kernel's own
+// number format, derived exactly the way the original viewers did it
+struct viewport
+{
+  escape_line_fn line;              // scalar kernel of the view
+  escape_resume_fn resume;          // and its resume kernel, NULL for
+                                    // views that can't be resumed
+  double MinRe, MaxIm, factor;
+  float sMinRe, sMaxIm, sFactor;    // NUMERIC_FLOAT
+  float skRe, skIm;
+  fixed_point_t fMinRe, fMaxIm, fFactor;
+  fixed_point_t fkRe, fkIm;
+  fixed_format_t format;            // NUMERIC_FIXED, never FIXED_AUTO
+  fixed124_t wMinRe, wMaxIm, wFactor; // 4.60 and 4.124 values in their
+  fixed124_t wkRe, wkIm;              // own format
+  const reference_orbit_t* orbit;   // NUMERIC_PERTURBATION, NULL if it
+                                    // could not be allocated
+  series_t series;                  // skip 0 when not approximating
+  simd_level_t simd;
+  bool interior;      // cardioid/bulb test and cycle detection
+  unsigned long* rebased;           // pixels rebased, all threads
+  float* magnitudes;  // |z|^2 of the frame's pixels, laid out like the
+                      // counts; NULL when only counts are wanted
+  escape_state_t* states; // likewise, NULL unless resumable and wanted
+};
+
+// Iteration counts of pixels [x0, x1) of row y, written to row[x0..x1),
+// and their |z|^2 and escape state to vp->magnitudes and vp->states if set
+void iterateSpan(const view_t* view, const viewport_t* vp, unsigned y,
+                 unsigned x0, unsigned x1, uint32_t* row);
+
+// Iteration counts of pixels [y0, y1) of column x, written into the
+// row-major iteration buffer
+void iterateColumnSpan(const view_t* view, const viewport_t* vp, unsigned x,
+                       unsigned y0, unsigned y1, uint32_t* iterations);
+
+// Corner, step and Julia constant in the wide format vp->format
+void setupWideViewport(const view_t* view, viewport_t* vp);
+
+kernel_kind_t kernelKind(const view_t* view);
+
+// Scalar kernel for the view's fractal in the number format of view->numeric
+// and vp->format, specialised for its MaxIterations where there is a copy.
+// Perturbation views get the double one.
+escape_line_fn escapeLine(const view_t* view, const viewport_t* vp);
+
+// Scalar resume kernel for the view, NULL for the formats that keep no z
+escape_resume_fn escapeResume(const view_t* view, const viewport_t* vp);
+
+// Reference orbit of the view centre, computed at the precision the step
+// needs or reused from the last call. Returns NULL on allocation failure.
+const reference_orbit_t* referenceOrbit(const view_t* view);
+
+// Largest number of iterations every pixel of the (panned) view can skip
+// with the series, validated against probe pixels at the frame's corners
+// and edges. The result is cached for views with the same orbit and frame.
+void approximateSeries(const view_t* view, const reference_orbit_t* orbit,
+                       series_t* series);
+
+// Perturbation counterpart of the escape_line_fn kernels, Mandelbrot and
+// Julia sets only. Perturbation pixels can't be resumed, state is ignored.
+void iterateLinePerturbation(const view_t* view, const viewport_t* vp,
+                             bool column, unsigned line, unsigned t0,
+                             unsigned t1, unsigned stride, unsigned shift,
+                             uint32_t* out, float* magnitude,
+                             escape_state_t* state);
+
+// Mariani-Silver subdivision of the tile [x0, x1) x [y0, y1). Returns the
+// number of pixels that were filled in without iterating. Filled pixels
+// take the |z|^2 of the rectangle's corner and start over when resumed.
+unsigned long computeTileMarianiSilver(const view_t* view,
+                                       const viewport_t* vp,
+                                       uint32_t* iterations,
+                                       unsigned x0, unsigned y0,
+                                       unsigned x1, unsigned y1);
+
+#endif // RENDER_INTERNAL_SW_H
@@ -0,0 +1,1166 @@
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "render_internal_sw.h"
+#include "tile_pool_sw.h"
+#include "tile_cache_sw.h"
+#include "tile_store_sw.h"
+#include "kernel_simd_sw.h"
+#include "interior_sw.h"
+
+// Edge length of the square tiles handed to the thread pool. Subdivision
+// tiles are larger so that uniform regions can be filled in bigger blocks.
+#define TILE_SIZE 32
+#define MARIANI_SILVER_TILE_SIZE 64
+// Column pixels handed to the kernels at a time
+#define COLUMN_CHUNK 64
+// Grid spacing of the first progressive pass
+#define PROGRESSIVE_COARSEST 8
+// Pixels of a computePixels() list handed to the thread pool at a time
+#define PIXEL_CHUNK 256
+// Tile cache budget unless $MANDELBROT_TILE_CACHE gives one in MiB
+#define TILE_CACHE_BUDGET ((size_t)64 << 20)
+
+typedef struct
+{
+  const view_t* view;
+  viewport_t vp;
+  uint32_t* iterations;
+  unsigned x0, y0, x1, y1;  // region being computed
+  long origin_x, origin_y;  // top-left corner of the first tile, brute
+                            // force tiles sit on the plane's tile grid
+  unsigned tile_size;
+  unsigned tiles_x;
+  tile_cache_t* cache;      // brute force only, NULL when disabled
+  tile_store_t* store;      // likewise
+  uint64_t plane;           // cache key of the view's plane
+  render_mode_t mode;
+  unsigned spacing;       // progressive pass: grid spacing and the spacing
+  unsigned skip;          // of the previous pass (0 for none)
+  uint32_t from;          // limit the counts were computed with when
+                          // resuming them, 0 for a render
+  unsigned long filled;   // pixels filled by subdivision, all threads
+  unsigned long rebased;  // pixels rebased by perturbation, all threads
+  unsigned long resumed;  // pixels iterated further, all threads
+} tile_job_t;
+
+static tile_pool_t* pool;
+static tile_cache_t* cache;
+static size_t cache_budget = TILE_CACHE_BUDGET;
+static bool cache_budget_read;  // $MANDELBROT_TILE_CACHE looked at
+static tile_store_t* store;
+static bool store_opened;       // $MANDELBROT_TILE_STORE looked at
+static int simd_level = -1;   // detected on first use
+static bool interior_detection = true;
+static bool series_approximation = false;
+static fixed_format_t fixed_format = FIXED_AUTO;
+static render_mode_t render_mode = RENDER_BRUTE_FORCE;
+static unsigned long last_filled;
+static unsigned long last_rebased;
+static unsigned long last_resumed;
+static unsigned last_series_skip;
+static const bool* cancel_flag;
+static render_progress_fn progress_fn;
+static void* progress_context;
+
+double zoomToStep(double zoom, uint32_t height)
+{
+  return (double)0.01 / ((height/500.0)*zoom);
+}
+
+double stepToZoom(double step, uint32_t height)
+{
+  return (double)0.01 / ((height/500.0)*step);
+}
+
+void recentreView(view_t* view)
+{
+  if(view->numeric == NUMERIC_PERTURBATION)
+  {
+    // the pan would be rounded away in a double centre
+    bigfix_t pan;
+    bigfixFromDouble(&pan, view->panX * view->step);
+    bigfixAdd(&view->deepRe, &view->deepRe, &pan, BIGFIX_LIMBS);
+    bigfixFromDouble(&pan, -view->panY * view->step);
+    bigfixAdd(&view->deepIm, &view->deepIm, &pan, BIGFIX_LIMBS);
+  }
+  else
+  {
+    view->cRe += view->panX * view->step;
+    view->cIm -= view->panY * view->step;
+  }
+  view->panX = 0;
+  view->panY = 0;
+}
+
+void offsetView(view_t* view, double dx, double dy)
+{
+  // the formats that read the deep centre lose a double's shift in cRe
+  if(view->numeric == NUMERIC_PERTURBATION
+     || (view->numeric == NUMERIC_FIXED
+         && viewFixedFormat(view) != FIXED_4_29))
+  {
+    bigfix_t offset;
+    bigfixFromDouble(&offset, dx * view->step);
+    bigfixAdd(&view->deepRe, &view->deepRe, &offset, BIGFIX_LIMBS);
+    bigfixFromDouble(&offset, -dy * view->step);
+    bigfixAdd(&view->deepIm, &view->deepIm, &offset, BIGFIX_LIMBS);
+  }
+  else
+  {
+    view->cRe += dx * view->step;
+    view->cIm -= dy * view->step;
+  }
+}
+
+int setDeepCentre(view_t* view, const char* re, const char* im)
+{
+  bigfix_t c_re, c_im, rounded;
+  if(bigfixFromString(&c_re, re) != 0 || bigfixFromString(&c_im, im) != 0)
+    return -1;
+
+  // the double part keeps working for everything that only needs a rough
+  // centre, the remainder holds the digits it can't
+  view->cRe = bigfixToDouble(&c_re);
+  view->cIm = bigfixToDouble(&c_im);
+  bigfixFromDouble(&rounded, view->cRe);
+  bigfixSub(&view->deepRe, &c_re, &rounded, BIGFIX_LIMBS);
+  bigfixFromDouble(&rounded, view->cIm);
+  bigfixSub(&view->deepIm, &c_im, &rounded, BIGFIX_LIMBS);
+  return 0;
+}
+
+static void setupViewport(const view_t* view, viewport_t* vp)
+{
+  uint32_t ImageWidth = view->width;
+  uint32_t ImageHeight = view->height;
+  kernel_kind_t kind = kernelKind(view);
+
+  // perturbation views of the other fractals use these too
+  vp->factor = view->step;
+  vp->MinRe = view->cRe - vp->factor*(ImageWidth/2);
+  double MinIm = view->cIm - vp->factor*(ImageHeight/2);
+  vp->MaxIm = MinIm + vp->factor*ImageHeight;
+
+  if(view->numeric == NUMERIC_FLOAT)
+  {
+    vp->sFactor = (float)view->step;
+    vp->sMinRe = (float)view->cRe - vp->sFactor*(ImageWidth/2);
+    float sMinIm = (float)view->cIm - vp->sFactor*(ImageHeight/2);
+    vp->sMaxIm = sMinIm + vp->sFactor*ImageHeight;
+    vp->skRe = (float)view->kRe;
+    vp->skIm = (float)view->kIm;
+  }
+  else if(view->numeric == NUMERIC_PERTURBATION
+          && (kind == KERNEL_MANDELBROT || kind == KERNEL_JULIA))
+  {
+    vp->orbit = referenceOrbit(view);
+    vp->series.skip = 0;
+    if(series_approximation && vp->orbit != NULL)
+      approximateSeries(view, vp->orbit, &vp->series);
+  }
+  else if(view->numeric == NUMERIC_FIXED
+          && (vp->format = viewFixedFormat(view)) != FIXED_4_29)
+  {
+    setupWideViewport(view, vp);
+  }
+  else if(view->numeric == NUMERIC_FIXED)
+  {
+    fixed_point_t factor = floatToFixed(view->step);
+    fixed_point_t cRe = floatToFixed(view->cRe);
+    fixed_point_t cIm = floatToFixed(view->cIm);
+
+    vp->fFactor = factor;
+    vp->fMinRe = cRe - multFixed(factor, floatToFixed(ImageWidth/2));
+    fixed_point_t MinIm = cIm - multFixed(factor,
+                                          floatToFixed(ImageHeight/2));
+    vp->fMaxIm = MinIm + multFixed(factor, floatToFixed(ImageHeight));
+    vp->fkRe = floatToFixed(view->kRe);
+    vp->fkIm = floatToFixed(view->kIm);
+  }
+
+  vp->line = escapeLine(view, vp);
+  vp->resume = escapeResume(view, vp);
+  if(view->numeric == NUMERIC_PERTURBATION
+     && (kind == KERNEL_MANDELBROT || kind == KERNEL_JULIA))
+    vp->line = iterateLinePerturbation;
+}
+
+// Leading pixels of a line in the vector kernels, returns the first pixel
+// they left to the scalar one
+static unsigned vectorLineDouble(const view_t* view, const viewport_t* vp,
+                                 bool column, unsigned line, unsigned t0,
+                                 unsigned t1, unsigned stride, unsigned shift,
+                                 uint32_t* out, float* magnitude,
+                                 double* state)
+{
+  // positions in the panned image, see view_t
+  long line_at = (long)line + (column ? view->panX : view->panY);
+  int32_t offset = (column ? view->panY : view->panX) + shift;
+
+  double_row_t row = {
+    .MinRe = vp->MinRe,
+    .factor = vp->factor,
+    .c_im = vp->MaxIm - line_at*vp->factor,
+    .column = column,
+    .c_re = vp->MinRe + line_at*vp->factor,
+    .MaxIm = vp->MaxIm,
+    .stride = stride,
+    .offset = offset,
+    .julia = view->fractal == FRACTAL_JULIA,
+    .k_re = view->kRe,
+    .k_im = view->kIm,
+    .MaxIterations = view->MaxIterations,
+    .interior = vp->interior
+  };
+  if(vp->simd == SIMD_AVX512)
+    return iterateRowDoubleAVX512(&row, t0, t1, out, magnitude, state);
+  if(vp->simd == SIMD_AVX2)
+    return iterateRowDoubleAVX2(&row, t0, t1, out, magnitude, state);
+  return t0;
+}
+
+static unsigned vectorLineFixed(const view_t* view, const viewport_t* vp,
+                                bool column, unsigned line, unsigned t0,
+                                unsigned t1, unsigned stride, unsigned shift,
+                                uint32_t* out, float* magnitude,
+                                double* state)
+{
+  long line_at = (long)line + (column ? view->panX : view->panY);
+  int32_t offset = (column ? view->panY : view->panX) + shift;
+
+  fixed_row_t row = {
+    .MinRe = vp->fMinRe,
+    .factor = vp->fFactor,
+    .c_im = vp->fMaxIm - multFixed(floatToFixed(line_at), vp->fFactor),
+    .column = column,
+    .c_re = vp->fMinRe + multFixed(floatToFixed(line_at), vp->fFactor),
+    .MaxIm = vp->fMaxIm,
+    .stride = stride,
+    .offset = offset,
+    .julia = view->fractal == FRACTAL_JULIA,
+    .k_re = vp->fkRe,
+    .k_im = vp->fkIm,
+    .MaxIterations = view->MaxIterations,
+    .interior = vp->interior
+  };
+  if(vp->simd == SIMD_AVX512)
+    return iterateRowFixedAVX512(&row, t0, t1, out, magnitude, state);
+  if(vp->simd == SIMD_AVX2)
+    return iterateRowFixedAVX2(&row, t0, t1, out, magnitude, state);
+  return t0;
+}
+
+// The vector kernels write the escape state as pairs of doubles, which is
+// how escape_state_t is laid out
+static void iterateLine(const view_t* view, const viewport_t* vp,
+                        bool column, unsigned line, unsigned t0, unsigned t1,
+                        unsigned stride, unsigned shift, uint32_t* out,
+                        float* magnitude, escape_state_t* state)
+{
+  unsigned t = t0;
+  if(view->numeric == NUMERIC_DOUBLE)
+    t = vectorLineDouble(view, vp, column, line, t0, t1, stride, shift, out,
+                         magnitude, (double*)state);
+  else if(view->numeric == NUMERIC_FIXED && vp->format == FIXED_4_29)
+    t = vectorLineFixed(view, vp, column, line, t0, t1, stride, shift, out,
+                        magnitude, (double*)state);
+
+  if(t < t1)
+    vp->line(view, vp, column, line, t, t1, stride, shift, out + (t - t0),
+             magnitude != NULL ? magnitude + (t - t0) : NULL,
+             state != NULL ? state + (t - t0) : NULL);
+}
+
+void iterateSpan(const view_t* view, const viewport_t* vp, unsigned y,
+                 unsigned x0, unsigned x1, uint32_t* row)
+{
+  size_t at = (size_t)y*view->width + x0;
+  iterateLine(view, vp, false, y, x0, x1, 1, 0, row + x0,
+              vp->magnitudes != NULL ? vp->magnitudes + at : NULL,
+              vp->states != NULL ? vp->states + at : NULL);
+}
+
+void iterateColumnSpan(const view_t* view, const viewport_t* vp, unsigned x,
+                       unsigned y0, unsigned y1, uint32_t* iterations)
+{
+  // the kernels write contiguously, so columns go through a small buffer
+  uint32_t buffer[COLUMN_CHUNK];
+  float magnitude[COLUMN_CHUNK];
+  escape_state_t state[COLUMN_CHUNK];
+  float* magnitudes = vp->magnitudes;
+  escape_state_t* states = vp->states;
+
+  for(unsigned y = y0; y < y1; y += COLUMN_CHUNK)
+  {
+    unsigned end = y + COLUMN_CHUNK < y1 ? y + COLUMN_CHUNK : y1;
+    iterateLine(view, vp, true, x, y, end, 1, 0, buffer,
+                magnitudes != NULL ? magnitude : NULL,
+                states != NULL ? state : NULL);
+
+    for(unsigned i = y; i < end; i++)
+      iterations[(size_t)i*view->width + x] = buffer[i - y];
+    if(magnitudes != NULL)
+      for(unsigned i = y; i < end; i++)
+        magnitudes[(size_t)i*view->width + x] = magnitude[i - y];
+    if(states != NULL)
+      for(unsigned i = y; i < end; i++)
+        states[(size_t)i*view->width + x] = state[i - y];
+  }
+}
+
+// Pixels of the tile on the grid of the job's spacing that are not on the
+// grid of the previous pass. Grid tiles are TILE_SIZE samples wide.
+static void computeTileGrid(const tile_job_t* job, unsigned x0, unsigned y0,
+                            unsigned x1, unsigned y1)
+{
+  const view_t* view = job->view;
+  unsigned spacing = job->spacing, skip = job->skip;
+  uint32_t buffer[TILE_SIZE];
+  float magnitude[TILE_SIZE];
+  escape_state_t state[TILE_SIZE];
+  float* magnitudes = job->vp.magnitudes;
+  escape_state_t* states = job->vp.states;
+
+  for(unsigned y = (y0 + spacing - 1) / spacing * spacing; y < y1;
+      y += spacing)
+  {
+    // rows of the previous grid already hold every other sample
+    bool coarse_row = skip != 0 && y % skip == 0;
+    unsigned stride = coarse_row ? skip : spacing;
+    unsigned shift = coarse_row ? spacing : 0;
+    unsigned t0 = x0 > shift ? (x0 - shift + stride - 1) / stride : 0;
+    unsigned t1 = x1 > shift ? (x1 - shift + stride - 1) / stride : 0;
+    if(t0 >= t1)
+      continue;
+
+    iterateLine(view, &job->vp, false, y, t0, t1, stride, shift, buffer,
+                magnitudes != NULL ? magnitude : NULL,
+                states != NULL ? state : NULL);
+    uint32_t* row = job->iterations + (size_t)y*view->width;
+    for(unsigned t = t0; t < t1; t++)
+      row[t*stride + shift] = buffer[t - t0];
+    if(magnitudes != NULL)
+      for(unsigned t = t0; t < t1; t++)
+        magnitudes[(size_t)y*view->width + t*stride + shift] =
+          magnitude[t - t0];
+    if(states != NULL)
+      for(unsigned t = t0; t < t1; t++)
+        states[(size_t)y*view->width + t*stride + shift] = state[t - t0];
+  }
+}
+
+// Brute-force tile at (tile_x, tile_y) on the plane's grid, of which
+// [x0, x1) x [y0, y1) is in the region. The region part is copied from the
+// cache or the store if either holds the tile, else computed; whole tiles
+// are then cached and stored.
+static void computeTileCached(const tile_job_t* job, long tile_x,
+                              long tile_y, unsigned x0, unsigned y0,
+                              unsigned x1, unsigned y1)
+{
+  const view_t* view = job->view;
+  uint32_t counts[TILE_SIZE * TILE_SIZE];
+  tile_key_t key = {
+    .plane = job->plane,
+    .x = (tile_x + view->panX) / TILE_SIZE,
+    .y = (tile_y + view->panY) / TILE_SIZE
+  };
+  bool hit = job->cache != NULL && tileCacheLookup(job->cache, &key, counts);
+  if(!hit && job->store != NULL && tileStoreLookup(job->store, &key, counts))
+  {
+    hit = true;
+    if(job->cache != NULL)
+      tileCacheInsert(job->cache, &key, counts);
+  }
+
+  for(unsigned y = y0; y < y1; y++)
+  {
+    uint32_t* row = job->iterations + (size_t)y*view->width;
+    uint32_t* cached = counts + (y - tile_y)*TILE_SIZE + (x0 - tile_x);
+    if(hit)
+    {
+      memcpy(row + x0, cached, (x1 - x0) * sizeof(uint32_t));
+      // cached tiles keep no orbits, their pixels start over if resumed
+      if(job->vp.states != NULL)
+        for(unsigned x = x0; x < x1; x++)
+          job->vp.states[(size_t)y*view->width + x] =
+            (escape_state_t){INFINITY, INFINITY};
+    }
+    else
+    {
+      iterateSpan(view, &job->vp, y, x0, x1, row);
+      memcpy(cached, row + x0, (x1 - x0) * sizeof(uint32_t));
+    }
+  }
+
+  bool whole = x0 == tile_x && y0 == tile_y && x1 == tile_x + TILE_SIZE
+               && y1 == tile_y + TILE_SIZE;
+  if(hit || !whole)
+    return;
+  if(job->cache != NULL)
+    tileCacheInsert(job->cache, &key, counts);
+  if(job->store != NULL)
+    tileStoreAppend(job->store, &key, counts);
+}
+
+// Resumed pixels xs[0..count) of row y in the vector kernels, through
+// compact buffers. c is derived as by the row kernels, so the counts are
+// those of iterating to the new limit in one go.
+static void resumeLineDouble(const view_t* view, const viewport_t* vp,
+                             unsigned y, const unsigned* xs, unsigned count,
+                             uint32_t from, uint32_t* row, float* magnitude,
+                             escape_state_t* state)
+{
+  double c_re[TILE_SIZE], c_im[TILE_SIZE], z_re[TILE_SIZE], z_im[TILE_SIZE];
+  uint32_t out[TILE_SIZE];
+  float r2[TILE_SIZE];
+  escape_state_t kept[TILE_SIZE];
+  long y_at = (long)y + view->panY;
+
+  for(unsigned i = 0; i < count; i++)
+  {
+    long x_at = (long)xs[i] + view->panX;
+    c_re[i] = vp->MinRe + x_at*vp->factor;
+    c_im[i] = vp->MaxIm - y_at*vp->factor;
+    z_re[i] = state[xs[i]].re;
+    z_im[i] = state[xs[i]].im;
+  }
+
+  double_row_t line = {
+    .julia = view->fractal == FRACTAL_JULIA,
+    .k_re = view->kRe,
+    .k_im = view->kIm,
+    .MaxIterations = view->MaxIterations,
+    .interior = vp->interior
+  };
+  double_resume_t resume = {c_re, c_im, z_re, z_im, from};
+  float* r2_out = magnitude != NULL ? r2 : NULL;
+  if(vp->simd == SIMD_AVX512)
+    resumeRowDoubleAVX512(&line, &resume, 0, count, out, r2_out,
+                          (double*)kept);
+  else
+    resumeRowDoubleAVX2(&line, &resume, 0, count, out, r2_out,
+                        (double*)kept);
+
+  for(unsigned i = 0; i < count; i++)
+  {
+    row[xs[i]] = out[i];
+    state[xs[i]] = kept[i];
+    if(magnitude != NULL)
+      magnitude[xs[i]] = r2[i];
+  }
+}
+
+static void resumeLineFixed(const view_t* view, const viewport_t* vp,
+                            unsigned y, const unsigned* xs, unsigned count,
+                            uint32_t from, uint32_t* row, float* magnitude,
+                            escape_state_t* state)
+{
+  fixed_point_t c_re[TILE_SIZE], c_im[TILE_SIZE];
+  fixed_point_t z_re[TILE_SIZE], z_im[TILE_SIZE];
+  uint32_t out[TILE_SIZE];
+  float r2[TILE_SIZE];
+  escape_state_t kept[TILE_SIZE];
+  long y_at = (long)y + view->panY;
+
+  for(unsigned i = 0; i < count; i++)
+  {
+    long x_at = (long)xs[i] + view->panX;
+    c_re[i] = vp->fMinRe + multFixed(floatToFixed(x_at), vp->fFactor);
+    c_im[i] = vp->fMaxIm - multFixed(floatToFixed(y_at), vp->fFactor);
+    z_re[i] = floatToFixed(state[xs[i]].re);
+    z_im[i] = floatToFixed(state[xs[i]].im);
+  }
+
+  fixed_row_t line = {
+    .julia = view->fractal == FRACTAL_JULIA,
+    .k_re = vp->fkRe,
+    .k_im = vp->fkIm,
+    .MaxIterations = view->MaxIterations,
+    .interior = vp->interior
+  };
+  fixed_resume_t resume = {c_re, c_im, z_re, z_im, from};
+  float* r2_out = magnitude != NULL ? r2 : NULL;
+  if(vp->simd == SIMD_AVX512)
+    resumeRowFixedAVX512(&line, &resume, 0, count, out, r2_out,
+                         (double*)kept);
+  else
+    resumeRowFixedAVX2(&line, &resume, 0, count, out, r2_out,
+                       (double*)kept);
+
+  for(unsigned i = 0; i < count; i++)
+  {
+    row[xs[i]] = out[i];
+    state[xs[i]] = kept[i];
+    if(magnitude != NULL)
+      magnitude[xs[i]] = r2[i];
+  }
+}
+
+// Pixels of the tile that ran to the old limit job->from, carried on to the
+// view's MaxIterations: from their kept z in the vector or scalar resume
+// kernels, or over again where no z was kept. Lowering the limit only caps
+// the counts; pixels it caps lose their z.
+static unsigned long resumeTile(const tile_job_t* job, unsigned x0,
+                                unsigned y0, unsigned x1, unsigned y1)
+{
+  const view_t* view = job->view;
+  const viewport_t* vp = &job->vp;
+  uint32_t from = job->from, MaxIterations = view->MaxIterations;
+  unsigned long resumed = 0;
+
+  for(unsigned y = y0; y < y1; y++)
+  {
+    size_t at = (size_t)y*view->width;
+    uint32_t* row = job->iterations + at;
+    escape_state_t* state = vp->states + at;
+    float* magnitude = vp->magnitudes != NULL ? vp->magnitudes + at : NULL;
+
+    if(MaxIterations < from)
+    {
+      for(unsigned x = x0; x < x1; x++)
+        if(row[x] >= MaxIterations)
+        {
+          if(row[x] != from || !isnan(state[x].re))
+            state[x] = (escape_state_t){INFINITY, INFINITY};
+          row[x] = MaxIterations;
+        }
+      continue;
+    }
+
+    unsigned xs[TILE_SIZE], count = 0;
+    unsigned run = x1;    // start of a run of pixels to iterate over again
+    for(unsigned x = x0; x <= x1; x++)
+    {
+      bool over = x < x1 && row[x] == from && isinf(state[x].re);
+      if(over && run == x1)
+        run = x;
+      if(!over && run != x1)
+      {
+        iterateSpan(view, vp, y, run, x, row);
+        resumed += x - run;
+        run = x1;
+      }
+      if(x == x1 || row[x] != from || over)
+        continue;
+
+      if(isnan(state[x].re))
+        row[x] = MaxIterations;   // known to be inside
+      else
+        xs[count++] = x;
+    }
+    if(count == 0)
+      continue;
+
+    if(vp->simd != SIMD_SCALAR && view->numeric == NUMERIC_DOUBLE)
+      resumeLineDouble(view, vp, y, xs, count, from, row, magnitude, state);
+    else if(vp->simd != SIMD_SCALAR && view->numeric == NUMERIC_FIXED)
+      resumeLineFixed(view, vp, y, xs, count, from, row, magnitude, state);
+    else
+      vp->resume(view, vp, y, xs, count, row, magnitude, state);
+    resumed += count;
+  }
+  return resumed;
+}
+
+static void computeTile(void* context, unsigned tile, unsigned thread)
+{
+  tile_job_t* job = context;
+  const view_t* view = job->view;
+  unsigned size = job->tile_size;
+
+  if(renderCancelled())
+    return;
+
+  long tile_x = job->origin_x + (long)(tile % job->tiles_x) * size;
+  long tile_y = job->origin_y + (long)(tile / job->tiles_x) * size;
+  unsigned x0 = tile_x > job->x0 ? tile_x : job->x0;
+  unsigned y0 = tile_y > job->y0 ? tile_y : job->y0;
+  unsigned x1 = tile_x + size < job->x1 ? tile_x + size : job->x1;
+  unsigned y1 = tile_y + size < job->y1 ? tile_y + size : job->y1;
+
+  if(job->from != 0)
+  {
+    unsigned long resumed = resumeTile(job, x0, y0, x1, y1);
+    __atomic_fetch_add(&job->resumed, resumed, __ATOMIC_RELAXED);
+    return;
+  }
+
+  if(job->mode == RENDER_PROGRESSIVE)
+  {
+    computeTileGrid(job, x0, y0, x1, y1);
+    return;
+  }
+
+  if(job->mode == RENDER_MARIANI_SILVER)
+  {
+    unsigned long filled = computeTileMarianiSilver(view, &job->vp,
+                                                    job->iterations,
+                                                    x0, y0, x1, y1);
+    __atomic_fetch_add(&job->filled, filled, __ATOMIC_RELAXED);
+    return;
+  }
+
+  if(job->cache != NULL || job->store != NULL)
+  {
+    computeTileCached(job, tile_x, tile_y, x0, y0, x1, y1);
+    return;
+  }
+
+  for(unsigned y = y0; y < y1; y++)
+    iterateSpan(view, &job->vp, y, x0, x1,
+                job->iterations + (size_t)y*view->width);
+}
+
+void setRenderThreads(unsigned threads)
+{
+  destroyTilePool(pool);
+  pool = createTilePool(threads);
+}
+
+unsigned renderThreads()
+{
+  if(pool == NULL)
+    pool = createTilePool(0);
+  return pool != NULL ? tilePoolThreads(pool) : 1;
+}
+
+unsigned renderThreadBusy(double* seconds, unsigned count)
+{
+  unsigned threads = renderThreads();
+  if(pool == NULL)
+  {
+    if(count > 0)
+      seconds[0] = 0;
+    return 1;
+  }
+
+  double busy[threads];
+  tilePoolBusy(pool, busy);
+  for(unsigned i = 0; i < threads && i < count; i++)
+    seconds[i] = busy[i];
+  return threads;
+}
+
+void setRenderSimd(simd_level_t level)
+{
+  simd_level_t supported = detectSimdLevel();
+  simd_level = level < supported ? level : supported;
+}
+
+simd_level_t renderSimd()
+{
+  if(simd_level < 0)
+    simd_level = detectSimdLevel();
+  return simd_level;
+}
+
+void setInteriorDetection(bool enabled)
+{
+  interior_detection = enabled;
+}
+
+bool interiorDetection()
+{
+  return interior_detection;
+}
+
+void setFixedFormat(fixed_format_t format)
+{
+  fixed_format = format;
+}
+
+fixed_format_t fixedFormat()
+{
+  return fixed_format;
+}
+
+fixed_format_t viewFixedFormat(const view_t* view)
+{
+  if(view->fractal == FRACTAL_MULTIBROT)
+    return FIXED_4_29;
+  return fixed_format == FIXED_AUTO ? fixedFormatFor(view->step)
+                                    : fixed_format;
+}
+
+long parseIterations(const char* text)
+{
+  char* end;
+  errno = 0;
+  unsigned long limit = strtoul(text, &end, 10);
+  if(errno != 0 || end == text || *end != '\0' || *text == '-'
+     || limit == 0 || limit > RENDER_MAX_ITERATIONS)
+    return -1;
+  return (long)limit;
+}
+
+static const char* fixed_format_names[] = {"4.29", "4.60", "4.124", "auto"};
+
+int parseFixedFormat(const char* name)
+{
+  for(int format = FIXED_4_29; format <= FIXED_AUTO; format++)
+    if(strcmp(name, fixed_format_names[format]) == 0)
+      return format;
+  return -1;
+}
+
+const char* fixedFormatName(fixed_format_t format)
+{
+  return fixed_format_names[format];
+}
+
+void setSeriesApproximation(bool enabled)
+{
+  series_approximation = enabled;
+}
+
+bool seriesApproximation()
+{
+  return series_approximation;
+}
+
+unsigned viewSeriesSkip(const view_t* view)
+{
+  if(view->numeric != NUMERIC_PERTURBATION || !series_approximation)
+    return 0;
+  // the reference orbit and the series are cached, so the render that
+  // follows doesn't fit them again
+  viewport_t vp = {0};
+  setupViewport(view, &vp);
+  return vp.series.skip;
+}
+
+// The viewers switch modes from the X thread while the render thread reads
+// it, hence the atomics
+void setRenderMode(render_mode_t mode)
+{
+  __atomic_store_n(&render_mode, mode, __ATOMIC_RELAXED);
+}
+
+render_mode_t renderMode()
+{
+  return __atomic_load_n(&render_mode, __ATOMIC_RELAXED);
+}
+
+void setRenderCancelFlag(const bool* flag)
+{
+  cancel_flag = flag;
+}
+
+bool renderCancelled()
+{
+  return cancel_flag != NULL && __atomic_load_n(cancel_flag, __ATOMIC_RELAXED);
+}
+
+void setRenderProgress(render_progress_fn fn, void* context)
+{
+  progress_fn = fn;
+  progress_context = context;
+}
+
+unsigned long renderFilledPixels()
+{
+  return last_filled;
+}
+
+unsigned long renderRebasedPixels()
+{
+  return last_rebased;
+}
+
+unsigned renderSeriesSkip()
+{
+  return last_series_skip;
+}
+
+// Hash of everything that decides a pixel's count besides its position
+// on the lattice of the view, i.e. (x + panX, y + panY)
+static uint64_t tilePlane(const view_t* view, const viewport_t* vp)
+{
+  uint64_t hash = TILE_PLANE_SEED;
+  hash = hashTilePlane(hash, &view->fractal, sizeof(view->fractal));
+  hash = hashTilePlane(hash, &view->power, sizeof(view->power));
+  hash = hashTilePlane(hash, &view->numeric, sizeof(view->numeric));
+  hash = hashTilePlane(hash, &vp->format, sizeof(vp->format));
+  hash = hashTilePlane(hash, &view->width, sizeof(view->width));
+  hash = hashTilePlane(hash, &view->height, sizeof(view->height));
+  hash = hashTilePlane(hash, &view->MaxIterations,
+                       sizeof(view->MaxIterations));
+  hash = hashTilePlane(hash, &view->cRe, sizeof(view->cRe));
+  hash = hashTilePlane(hash, &view->cIm, sizeof(view->cIm));
+  hash = hashTilePlane(hash, &view->step, sizeof(view->step));
+  hash = hashTilePlane(hash, &view->kRe, sizeof(view->kRe));
+  hash = hashTilePlane(hash, &view->kIm, sizeof(view->kIm));
+  hash = hashTilePlane(hash, &view->deepRe, sizeof(view->deepRe));
+  hash = hashTilePlane(hash, &view->deepIm, sizeof(view->deepIm));
+  // the series is fitted to the panned frame, pixels only agree between
+  // frames that skip the same number of iterations
+  return hashTilePlane(hash, &vp->series.skip, sizeof(vp->series.skip));
+}
+
+static tile_cache_t* tileCache()
+{
+  if(!cache_budget_read)
+  {
+    // MiB, anything but a whole number >= 0 keeps the default budget
+    const char* env = getenv("MANDELBROT_TILE_CACHE");
+    char* end = NULL;
+    long mb = env != NULL ? strtol(env, &end, 10) : -1;
+    if(end != env && *end == '\0' && mb >= 0)
+      cache_budget = ((unsigned long)mb < SIZE_MAX >> 20
+                      ? (size_t)mb : SIZE_MAX >> 20) << 20;
+    cache_budget_read = true;
+  }
+  if(cache == NULL && cache_budget > 0)
+    cache = createTileCache(cache_budget, TILE_SIZE * TILE_SIZE);
+  return cache_budget > 0 ? cache : NULL;
+}
+
+static tile_store_t* tileStore()
+{
+  if(!store_opened)
+  {
+    const char* path = getenv("MANDELBROT_TILE_STORE");
+    if(path != NULL && *path != '\0')
+      store = openTileStore(path, TILE_SIZE * TILE_SIZE);
+    store_opened = true;
+  }
+  return store;
+}
+
+int setTileStore(const char* path)
+{
+  closeTileStore(store);
+  store = NULL;
+  store_opened = true;
+  if(path == NULL)
+    return 0;
+  store = openTileStore(path, TILE_SIZE * TILE_SIZE);
+  return store != NULL ? 0 : -1;
+}
+
+tile_store_stats_t renderTileStoreStats()
+{
+  tile_store_t* current = tileStore();
+  if(current == NULL)
+    return (tile_store_stats_t){0};
+  return tileStoreStats(current);
+}
+
+void setTileCacheBudget(size_t bytes)
+{
+  cache_budget = bytes;
+  cache_budget_read = true;
+  if(cache != NULL)
+    setTileCacheLimit(cache, bytes);
+}
+
+tile_cache_stats_t renderTileCacheStats()
+{
+  tile_cache_t* current = tileCache();
+  if(current == NULL)
+    return (tile_cache_stats_t){.budget = cache_budget};
+  return tileCacheStats(current);
+}
+
+// Computes the region in the given mode, or resumes it from the limit
+// `from` unless that is 0
+static void runJob(const view_t* view, uint32_t* iterations,
+                   float* magnitudes, escape_state_t* states, unsigned x0,
+                   unsigned y0, unsigned x1, unsigned y1, render_mode_t mode,
+                   unsigned spacing, unsigned skip, uint32_t from)
+{
+  unsigned size = mode == RENDER_MARIANI_SILVER ? MARIANI_SILVER_TILE_SIZE
+                  : mode == RENDER_PROGRESSIVE ? TILE_SIZE * spacing
+                  : TILE_SIZE;
+  long origin_x = x0, origin_y = y0;
+  if(mode == RENDER_BRUTE_FORCE)
+  {
+    // back to the grid line at or left of / above the region, the lattice
+    // coordinates may be negative
+    origin_x -= ((x0 + view->panX) % (long)size + size) % size;
+    origin_y -= ((y0 + view->panY) % (long)size + size) % size;
+  }
+  tile_job_t job = {
+    .view = view,
+    .iterations = iterations,
+    .x0 = x0,
+    .y0 = y0,
+    .x1 = x1,
+    .y1 = y1,
+    .origin_x = origin_x,
+    .origin_y = origin_y,
+    .tile_size = size,
+    .tiles_x = (x1 - origin_x + size - 1) / size,
+    .mode = mode,
+    .spacing = spacing,
+    .skip = skip,
+    .from = from
+  };
+  setupViewport(view, &job.vp);
+  job.vp.magnitudes = magnitudes;
+  job.vp.states = resumableView(view) ? states : NULL;
+  // cached tiles only hold counts, resumed ones are not brute force
+  if(mode == RENDER_BRUTE_FORCE && magnitudes == NULL && from == 0)
+  {
+    job.cache = tileCache();
+    job.store = tileStore();
+    job.plane = tilePlane(view, &job.vp);
+  }
+  // the vector kernels only iterate z^2 + c
+  job.vp.simd = view->fractal == FRACTAL_MANDELBROT
+                || view->fractal == FRACTAL_JULIA ? renderSimd() : SIMD_SCALAR;
+  job.vp.interior = interior_detection;
+  job.vp.rebased = &job.rebased;
+  unsigned tiles_y = (y1 - origin_y + size - 1) / size;
+  unsigned count = job.tiles_x * tiles_y;
+
+  if(pool == NULL)
+    pool = createTilePool(0);
+
+  if(pool != NULL)
+    runTiles(pool, count, computeTile, &job);
+  else
+    for(unsigned tile = 0; tile < count; tile++)
+      computeTile(&job, tile, 0);
+
+  if(job.store != NULL)
+    flushTileStore(job.store);
+  last_filled += job.filled;
+  last_rebased += job.rebased;
+  last_resumed += job.resumed;
+  last_series_skip = job.vp.series.skip;
+}
+
+void computeRegionResumable(const view_t* view, uint32_t* iterations,
+                            float* magnitudes, escape_state_t* states,
+                            unsigned x0, unsigned y0, unsigned x1,
+                            unsigned y1)
+{
+  render_mode_t mode = renderMode();
+  last_filled = 0;
+  last_rebased = 0;
+  last_series_skip = 0;
+  if(x1 <= x0 || y1 <= y0)
+    return;
+
+  // strips exposed by a pan are cheap, only whole frames go in passes
+  bool whole = x0 == 0 && y0 == 0 && x1 == view->width
+               && y1 == view->height;
+  if(mode != RENDER_PROGRESSIVE || !whole)
+  {
+    runJob(view, iterations, magnitudes, states, x0, y0, x1, y1,
+           mode == RENDER_PROGRESSIVE ? RENDER_BRUTE_FORCE : mode, 1, 0, 0);
+    return;
+  }
+
+  for(unsigned spacing = PROGRESSIVE_COARSEST; spacing >= 1; spacing /= 2)
+  {
+    unsigned skip = spacing == PROGRESSIVE_COARSEST ? 0 : spacing * 2;
+    runJob(view, iterations, magnitudes, states, x0, y0, x1, y1, mode,
+           spacing, skip, 0);
+    if(renderCancelled())
+      return;
+    if(spacing > 1 && progress_fn != NULL)
+      progress_fn(progress_context, view, iterations, spacing);
+  }
+}
+
+void computeRegionSmooth(const view_t* view, uint32_t* iterations,
+                         float* magnitudes, unsigned x0, unsigned y0,
+                         unsigned x1, unsigned y1)
+{
+  computeRegionResumable(view, iterations, magnitudes, NULL, x0, y0, x1, y1);
+}
+
+void computeRegion(const view_t* view, uint32_t* iterations,
+                   unsigned x0, unsigned y0, unsigned x1, unsigned y1)
+{
+  computeRegionSmooth(view, iterations, NULL, x0, y0, x1, y1);
+}
+
+void computeIterations(const view_t* view, uint32_t* iterations)
+{
+  computeRegion(view, iterations, 0, 0, view->width, view->height);
+}
+
+void computeIterationsSmooth(const view_t* view, uint32_t* iterations,
+                             float* magnitudes)
+{
+  computeRegionSmooth(view, iterations, magnitudes, 0, 0, view->width,
+                      view->height);
+}
+
+bool resumableView(const view_t* view)
+{
+  return view->numeric == NUMERIC_DOUBLE || view->numeric == NUMERIC_FLOAT
+         || (view->numeric == NUMERIC_FIXED
+             && viewFixedFormat(view) == FIXED_4_29);
+}
+
+void resumeIterations(const view_t* view, uint32_t from,
+                      uint32_t* iterations, float* magnitudes,
+                      escape_state_t* states, unsigned x0, unsigned y0,
+                      unsigned x1, unsigned y1)
+{
+  last_resumed = 0;
+  if(x1 <= x0 || y1 <= y0 || from == view->MaxIterations
+     || !resumableView(view))
+    return;
+
+  runJob(view, iterations, magnitudes, states, x0, y0, x1, y1,
+         RENDER_BRUTE_FORCE, 1, 0, from);
+}
+
+unsigned long renderResumedPixels()
+{
+  return last_resumed;
+}
+
+typedef struct
+{
+  const view_t* view;
+  viewport_t vp;
+  const uint32_t* indices;
+  size_t count;
+  uint32_t* iterations;
+  float* magnitudes;
+  unsigned long rebased;
+} pixel_job_t;
+
+static void computePixelChunk(void* context, unsigned chunk, unsigned thread)
+{
+  pixel_job_t* job = context;
+  const view_t* view = job->view;
+
+  if(renderCancelled())
+    return;
+
+  size_t end = (size_t)(chunk + 1) * PIXEL_CHUNK;
+  if(end > job->count)
+    end = job->count;
+  size_t i = (size_t)chunk * PIXEL_CHUNK;
+  while(i < end)
+  {
+    uint32_t first = job->indices[i];
+    unsigned y = first / view->width, x0 = first % view->width;
+    unsigned run = 1;
+    while(i + run < end && job->indices[i + run] == first + run
+          && x0 + run < view->width)
+      run++;
+
+    iterateLine(view, &job->vp, false, y, x0, x0 + run, 1, 0,
+                job->iterations + i,
+                job->magnitudes != NULL ? job->magnitudes + i : NULL, NULL);
+    i += run;
+  } // while
+}
+
+void computePixels(const view_t* view, const uint32_t* indices,
+                   size_t count, uint32_t* iterations, float* magnitudes)
+{
+  if(count == 0)
+    return;
+
+  pixel_job_t job = {
+    .view = view,
+    .indices = indices,
+    .count = count,
+    .iterations = iterations,
+    .magnitudes = magnitudes
+  };
+  setupViewport(view, &job.vp);
+  job.vp.simd = view->fractal == FRACTAL_MANDELBROT
+                || view->fractal == FRACTAL_JULIA ? renderSimd() : SIMD_SCALAR;
+  job.vp.interior = interior_detection;
+  job.vp.rebased = &job.rebased;
+  unsigned chunks = (count + PIXEL_CHUNK - 1) / PIXEL_CHUNK;
+
+  if(pool == NULL)
+    pool = createTilePool(0);
+
+  if(pool != NULL)
+    runTiles(pool, chunks, computePixelChunk, &job);
+  else
+    for(unsigned chunk = 0; chunk < chunks; chunk++)
+      computePixelChunk(&job, chunk, 0);
+}
+
+void refineIterations(const view_t* view, uint32_t* iterations,
+                      unsigned spacing)
+{
+  last_filled = 0;
+  last_rebased = 0;
+  last_series_skip = 0;
+
+  for(unsigned pass = spacing / 2; pass >= 1; pass /= 2)
+  {
+    runJob(view, iterations, NULL, NULL, 0, 0, view->width, view->height,
+           RENDER_PROGRESSIVE, pass, pass * 2, 0);
+    if(renderCancelled())
+      return;
+  }
+}
+
+// Plain colour of an escaped count: count times a colour unit of
+// 2^24 / MaxIterations, or the count scaled in 64 bits for limits above
+// 2^24, whose unit would be 0
+static inline uint32_t plainColour(uint32_t n, uint32_t MaxIterations,
+                                   uint32_t colour_unit)
+{
+  if(colour_unit == 0)
+    return (uint32_t)(((uint64_t)n << 24) / MaxIterations);
+  return colour_unit * n;
+}
+
+void colourGrid(const view_t* view, const uint32_t* iterations,
+                uint32_t* pixels, unsigned spacing)
+{
+  uint32_t MaxIterations = view->MaxIterations;
+  uint32_t colour_unit = (uint32_t)((1 << 24) / (MaxIterations));
+
+  for(unsigned y = 0; y < view->height; y++)
+  {
+    const uint32_t* samples = iterations
+                              + (size_t)(y - y % spacing)*view->width;
+    uint32_t* row = pixels + (size_t)y*view->width;
+    for(unsigned x = 0; x < view->width; x++)
+    {
+      uint32_t n = samples[x - x % spacing];
+      row[x] = isInsideCount(n, MaxIterations)
+               ? 0 : plainColour(n, MaxIterations, colour_unit);
+    }
+  }
+}
+
+void colourIterations(const view_t* view, const uint32_t* iterations,
+                      uint32_t* pixels)
+{
+  uint32_t MaxIterations = view->MaxIterations;
+  uint32_t colour_unit = (uint32_t)((1 << 24) / (MaxIterations));
+  size_t count = (size_t)view->width * view->height;
+
+  for(size_t i = 0; i < count; i++)
+  {
+    uint32_t n = iterations[i];
+    pixels[i] = isInsideCount(n, MaxIterations)
+                ? 0 : plainColour(n, MaxIterations, colour_unit);
+  }
+}
+
+void renderView(const view_t* view, uint32_t* iterations, uint32_t* pixels)
+{
+  uint32_t* buffer = iterations;
+  if(buffer == NULL)
+    buffer = malloc((size_t)view->width * view->height * sizeof(uint32_t));
+  if(buffer == NULL)
+    return;
+
+  computeIterations(view, buffer);
+  colourIterations(view, buffer, pixels);
+
+  if(iterations == NULL)
+    free(buffer);
+}
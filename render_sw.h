@@ -0,0 +1,285 @@
+#ifndef RENDER_SW_H
+#define RENDER_SW_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bigfix_sw.h"
+#include "fixed_point_sw.h"
+#include "kernel_simd_sw.h"
+#include "tile_cache_sw.h"
+#include "tile_store_sw.h"
+
+/*
+  Display-independent render core: escape-time kernels that fill a buffer of
+  iteration counts and a colouring pass that turns it into 0x00RRGGBB pixels.
+  Nothing in here depends on X11, so it can be used by the interactive
+  viewers as well as by the headless tools.
+*/
+
+typedef enum
+{
+  FRACTAL_MANDELBROT,
+  FRACTAL_JULIA,
+  FRACTAL_BURNING_SHIP, // z = (|Re z| + |Im z| i)^2 + c
+  FRACTAL_MULTIBROT     // z = z^power + c
+} fractal_t;
+
+typedef enum
+{
+  NUMERIC_DOUBLE,       // IEEE double
+  NUMERIC_FLOAT,        // IEEE single, faster for shallow views
+  NUMERIC_FIXED,        // 4.29 fixed point, models the hardware datapath;
+                        // wider formats past its resolution, see
+                        // setFixedFormat
+  NUMERIC_PERTURBATION  // double deltas from a bigfix reference orbit, for
+                        // zooms past 1e13, see perturbation_sw.c. Other
+                        // fractals than Mandelbrot and Julia fall back to
+                        // double.
+} numeric_t;
+
+typedef struct
+{
+  fractal_t fractal;
+  numeric_t numeric;
+  uint32_t width;
+  uint32_t height;
+  uint32_t MaxIterations;
+  double cRe;       // centre of the image
+  double cIm;
+  double step;      // distance between two neighbouring pixels
+  double kRe;       // Julia constant, unused for the Mandelbrot set
+  double kIm;
+  uint32_t power;   // multibrot exponent, 3 or 4
+  int32_t panX;     // whole-pixel pan from the centre, x right and y down.
+  int32_t panY;     // Pixel (x, y) shows what (x + panX, y + panY) would at
+                    // zero pan, bit for bit, so panned frames can be reused
+  bigfix_t deepRe;  // perturbation and 4.60/4.124 fixed point only: the
+  bigfix_t deepIm;  // exact centre is (cRe + deepRe, cIm + deepIm), zero
+                    // for a double centre
+} view_t;
+
+typedef enum
+{
+  RENDER_BRUTE_FORCE,     // iterate every pixel
+  RENDER_MARIANI_SILVER,  // iterate rectangle borders, fill uniform ones
+  RENDER_PROGRESSIVE      // every pixel, coarse-to-fine, see setRenderProgress
+} render_mode_t;
+
+// Largest MaxIterations of a view: the vector kernels convert their counts
+// to signed 32-bit integers
+#define RENDER_MAX_ITERATIONS INT32_MAX
+
+// Iteration count of a pixel that never escaped
+#define isInsideCount(n, MaxIterations) ((n) >= (MaxIterations))
+
+// Where a pixel's orbit stood when it ran to MaxIterations without escaping,
+// so that a higher limit can carry on from there instead of from z = c. re
+// is NaN when there is nothing to carry on: the pixel escaped or is known
+// to be inside (main cardioid, period-2 bulb or an orbit caught in a
+// cycle). Pixels whose z was not kept, e.g. ones filled by Mariani-Silver
+// or copied from the tile cache, have re = INFINITY and start over.
+typedef struct
+{
+  double re;
+  double im;
+} escape_state_t;
+
+// Pixel spacing used by the viewers: 0.01 at zoom 1 on a 500 pixel high image
+double zoomToStep(double zoom, uint32_t height);
+
+// Zoom of a pixel spacing, the inverse of zoomToStep()
+double stepToZoom(double step, uint32_t height);
+
+// Folds panX/panY into the centre, e.g. before the step changes
+void recentreView(view_t* view);
+
+// Moves the centre of a view by dx, dy pixels (x right, y down), fractions
+// of a pixel included; a deep centre keeps its digits
+void offsetView(view_t* view, double dx, double dy);
+
+// Sets the centre of a view from decimal strings, to as many digits as
+// given and the number format holds. Returns -1 if either is not a number.
+int setDeepCentre(view_t* view, const char* re, const char* im);
+
+// Number of threads used to compute a frame, 0 picks $MANDELBROT_THREADS or
+// the number of online CPUs (the default)
+void setRenderThreads(unsigned threads);
+unsigned renderThreads();
+
+// Seconds each render thread has spent computing tiles so far, for at most
+// count threads; returns the number of threads. Diff two calls to time a
+// frame.
+unsigned renderThreadBusy(double* seconds, unsigned count);
+
+// Vector kernel used for the double and 4.29 Mandelbrot and Julia sets,
+// defaults to the widest one the CPU supports; requests above that are
+// capped
+void setRenderSimd(simd_level_t level);
+simd_level_t renderSimd();
+
+// Marks points in the main cardioid / period-2 bulb and orbits caught in a
+// cycle as inside without iterating to MaxIterations (on by default). The
+// switch exists for A/B benchmarking, the image is the same either way.
+void setInteriorDetection(bool enabled);
+bool interiorDetection();
+
+// Brute-force tiles are kept in an LRU cache of at most bytes, keyed by the
+// view's plane (everything but the pan) and their position on it, so a
+// view seen before at the same zoom, or panned back to, is copied instead
+// of iterated. The default is 64 MiB or $MANDELBROT_TILE_CACHE MiB, 0 turns
+// the cache off. Progressive and Mariani-Silver frames are not cached.
+void setTileCacheBudget(size_t bytes);
+tile_cache_stats_t renderTileCacheStats();
+
+// Whole brute-force tiles are also appended to the tile store at path, and
+// tiles the cache misses are looked up there, so a new process starts with
+// every region rendered before at hand. The default is the file named by
+// $MANDELBROT_TILE_STORE, if set; NULL closes the store. Returns -1 if the
+// file can't be opened or is not a tile store.
+int setTileStore(const char* path);
+tile_store_stats_t renderTileStoreStats();
+
+// Fixed-point format of NUMERIC_FIXED views. FIXED_AUTO (the default) uses
+// 4.29 while it resolves the step, so shallow views are computed exactly
+// as by the hardware model, then 4.60 and 4.124. Multibrots always use
+// 4.29, the wider formats have no room for z^3.
+void setFixedFormat(fixed_format_t format);
+fixed_format_t fixedFormat();
+
+// Format a NUMERIC_FIXED view is computed in, FIXED_AUTO resolved
+fixed_format_t viewFixedFormat(const view_t* view);
+
+// Parses an iteration limit, returns -1 unless it is a whole number in
+// [1, RENDER_MAX_ITERATIONS]
+long parseIterations(const char* text);
+
+// Parses "auto", "4.29", "4.60" or "4.124", returns -1 if unknown
+int parseFixedFormat(const char* name);
+const char* fixedFormatName(fixed_format_t format);
+
+// Perturbation views start every pixel from a series approximation of its
+// offset from the reference orbit, skipping the iterations the whole frame
+// shares (off by default). The series is cut off where probe pixels show it
+// losing precision, but counts can still differ from full iteration by one
+// or two near the boundary.
+void setSeriesApproximation(bool enabled);
+bool seriesApproximation();
+
+// Iterations every pixel of view would skip with the series approximation,
+// 0 unless it is a perturbation view and the approximation is on
+unsigned viewSeriesSkip(const view_t* view);
+
+// Mariani-Silver relies on the set being connected: a rectangle whose
+// border has one iteration count everywhere is filled without iterating
+// its inside. Filaments thinner than a pixel can be missed, and Julia sets
+// for c outside the Mandelbrot set and the Burning Ship are not connected.
+void setRenderMode(render_mode_t mode);
+render_mode_t renderMode();
+
+// Pixels the last computeIterations() filled in without iterating
+unsigned long renderFilledPixels();
+
+// Pixels of the last computeIterations() that glitched and were rebased
+// onto the start of the reference orbit (NUMERIC_PERTURBATION only)
+unsigned long renderRebasedPixels();
+
+// Iterations every pixel of the last computeIterations() skipped with the
+// series approximation
+unsigned renderSeriesSkip();
+
+// Once *flag becomes true, tiles that have not started yet are skipped, so
+// another thread can abandon a render; the buffer is then only partly
+// updated. NULL (the default) disables cancellation.
+void setRenderCancelFlag(const bool* flag);
+bool renderCancelled();
+
+// Progressive mode computes whole frames in passes on grids of spacing 8,
+// 4, 2 and 1, each pass iterating only pixels that are not on the previous
+// grid, so the final counts are the brute-force ones at the same cost. fn
+// runs on the rendering thread after every pass but the last, when the
+// counts on the grid of that spacing are final; colourGrid() turns them
+// into a blocky preview.
+typedef void (*render_progress_fn)(void* context, const view_t* view,
+                                   const uint32_t* iterations,
+                                   unsigned spacing);
+void setRenderProgress(render_progress_fn fn, void* context);
+
+// Fills width * height iteration counts, row-major. The image is cut into
+// tiles that are spread over the render threads; calls must not overlap.
+void computeIterations(const view_t* view, uint32_t* iterations);
+
+// Like computeIterations() but only for pixels [x0, x1) x [y0, y1) of the
+// full-size buffer; the other pixels are left untouched
+void computeRegion(const view_t* view, uint32_t* iterations,
+                   unsigned x0, unsigned y0, unsigned x1, unsigned y1);
+
+// Like computeRegion() but also stores |z|^2 of every pixel, where it
+// escaped, in magnitudes (laid out like iterations) for colourSmooth(),
+// see palette_sw.h.
+// These tiles bypass the tile cache and store, which only hold counts;
+// Mariani-Silver gives filled pixels the |z|^2 of their rectangle's corner.
+void computeRegionSmooth(const view_t* view, uint32_t* iterations,
+                         float* magnitudes, unsigned x0, unsigned y0,
+                         unsigned x1, unsigned y1);
+
+void computeIterationsSmooth(const view_t* view, uint32_t* iterations,
+                             float* magnitudes);
+
+// True if the pixels of view can be resumed: double, float and 4.29 views.
+// The wider fixed-point formats and perturbation keep no z.
+bool resumableView(const view_t* view);
+
+// Like computeRegionSmooth() but also keeps the escape state of every pixel
+// in states (laid out like iterations) for resumeIterations(); magnitudes
+// may be NULL. Views that are not resumable leave states alone.
+void computeRegionResumable(const view_t* view, uint32_t* iterations,
+                            float* magnitudes, escape_state_t* states,
+                            unsigned x0, unsigned y0, unsigned x1,
+                            unsigned y1);
+
+// Brings pixels [x0, x1) x [y0, y1), computed by computeRegionResumable()
+// for the same plane with a MaxIterations of `from`, to view->MaxIterations
+// (view must be resumable). Raising the limit carries the pixels that hit
+// `from` on from their z, so escaped and known inside pixels cost nothing;
+// lowering it just caps the counts. Counts, magnitudes (unless NULL) and
+// states are updated as a render at the new limit would leave them. The
+// work is spread over the render threads and honours the cancel flag.
+void resumeIterations(const view_t* view, uint32_t from,
+                      uint32_t* iterations, float* magnitudes,
+                      escape_state_t* states, unsigned x0, unsigned y0,
+                      unsigned x1, unsigned y1);
+
+// Pixels the last resumeIterations() iterated further, whether from their
+// kept z or over again from z = c
+unsigned long renderResumedPixels();
+
+// Counts of count scattered pixels of view, given by their row-major
+// indices in increasing order, written to iterations[0..count) and their
+// |z|^2 to magnitudes[0..count) unless it is NULL. Runs of neighbouring
+// pixels go to the kernels together; the work is spread over the render
+// threads and honours the cancel flag, the tile cache is not used.
+void computePixels(const view_t* view, const uint32_t* indices,
+                   size_t count, uint32_t* iterations, float* magnitudes);
+
+// Like computeIterations() when the buffer already holds the counts on the
+// grid of the given spacing (a power of two), e.g. copied from a view of
+// spacing times the step whose pixels coincide with those: the progressive
+// passes below that spacing iterate the other pixels
+void refineIterations(const view_t* view, uint32_t* iterations,
+                      unsigned spacing);
+
+// Maps iteration counts to pixels, inside points are black
+void colourIterations(const view_t* view, const uint32_t* iterations,
+                      uint32_t* pixels);
+
+// Like colourIterations() but every pixel takes the colour of the sample
+// at the top-left corner of its spacing x spacing block
+void colourGrid(const view_t* view, const uint32_t* iterations,
+                uint32_t* pixels, unsigned spacing);
+
+// computeIterations() followed by colourIterations(), iterations may be NULL
+// in which case a temporary buffer is used
+void renderView(const view_t* view, uint32_t* iterations, uint32_t* pixels);
+
+#endif // RENDER_SW_H
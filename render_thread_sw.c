@@ -0,0 +1,324 @@
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "render_thread_sw.h"
+#include "iteration_frame_sw.h"
+
+struct render_thread
+{
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  int pipe_fd[2];           // read end polled by the X thread
+  uint32_t width;
+  uint32_t height;
+
+  // owned by the worker
+  iteration_frame_t frame;
+  uint32_t* back;
+  palette_t frame_palette;  // of the frame being rendered
+  unsigned long frames;     // complete frames rendered
+  uint32_t limit;           // MaxIterations the last frame settled on
+
+  // guarded by lock
+  view_t request;
+  bool pending;
+  bool cancel;              // also read by the tiles, see setRenderCancelFlag
+  bool quit;
+  palette_t palette;        // for the next request
+  bool smooth;
+  iteration_budget_t budget;  // for the next request
+  bool adaptive;
+  unsigned antialias;       // samples per side, 0 for off
+  uint32_t* ready;          // last finished frame
+  view_t ready_view;
+  bool ready_complete;      // false for a progressive preview
+  frame_stats_t ready_stats;  // of the last complete frame
+  bool have_ready;
+
+  // owned by the X thread
+  frame_stats_t taken_stats;
+  bool have_stats;
+};
+
+// Swaps back and ready and wakes up the X thread. Called with lock held.
+static void publish(render_thread_t* rt, const view_t* view, bool complete)
+{
+  uint32_t* finished = rt->back;
+  rt->back = rt->ready;
+  rt->ready = finished;
+  rt->ready_view = *view;
+  rt->ready_complete = complete;
+  if(!rt->have_ready)
+  {
+    rt->have_ready = true;
+    char token = 0;
+    ssize_t written = write(rt->pipe_fd[1], &token, 1);
+    (void)written; // a full pipe already wakes the X thread
+  }
+}
+
+// Gives every pixel the colour of the sample at the top-left corner of its
+// spacing x spacing block, in place
+static void spreadGrid(uint32_t* pixels, uint32_t width, uint32_t height,
+                       unsigned spacing)
+{
+  for(unsigned y = 0; y < height; y++)
+  {
+    const uint32_t* samples = pixels + (size_t)(y - y % spacing)*width;
+    uint32_t* row = pixels + (size_t)y*width;
+    for(unsigned x = 0; x < width; x++)
+      row[x] = samples[x - x % spacing];
+  }
+}
+
+// Progressive passes are shown as soon as they are done
+static void publishPass(void* context, const view_t* view,
+                        const uint32_t* iterations, unsigned spacing)
+{
+  render_thread_t* rt = context;
+  if(rt->frame.magnitudes != NULL)
+  {
+    // pixels off the grid are stale but overwritten by the spread
+    colourSmooth(view, iterations, rt->frame.magnitudes, &rt->frame_palette,
+                 rt->back);
+    spreadGrid(rt->back, view->width, view->height, spacing);
+  }
+  else
+  {
+    colourGrid(view, iterations, rt->back, spacing);
+  }
+
+  pthread_mutex_lock(&rt->lock);
+  publish(rt, view, false);
+  pthread_mutex_unlock(&rt->lock);
+}
+
+static void* renderLoop(void* arg)
+{
+  render_thread_t* rt = arg;
+
+  // the render core is only ever driven from this thread
+  setRenderCancelFlag(&rt->cancel);
+  setRenderProgress(publishPass, rt);
+
+  pthread_mutex_lock(&rt->lock);
+  while(true)
+  {
+    while(!rt->pending && !rt->quit)
+      pthread_cond_wait(&rt->wake, &rt->lock);
+    if(rt->quit)
+      break;
+
+    view_t view = rt->request;
+    rt->frame_palette = rt->palette;
+    bool smooth = rt->smooth;
+    iteration_budget_t budget = rt->budget;
+    bool adaptive = rt->adaptive;
+    unsigned antialias = rt->antialias;
+    rt->pending = false;
+    __atomic_store_n(&rt->cancel, false, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&rt->lock);
+
+    // without room for |z|^2 the frame is coloured plainly
+    if(setIterationFrameSmooth(&rt->frame, smooth) != 0)
+      setIterationFrameSmooth(&rt->frame, false);
+
+    frame_stats_t stats = {0};
+    frame_probe_t probe;
+    startFrameProbe(&probe);
+    if(adaptive)
+    {
+      // a pan or the next auto-zoom step needs about the last frame's
+      // limit, but not less than its zoom does
+      uint32_t floor = zoomIterations(&budget, &view);
+      view.MaxIterations = rt->limit > floor ? rt->limit : floor;
+    }
+    bool done = updateIterationFrame(&rt->frame, &view) == 0;
+    size_t reused = rt->frame.reused;
+
+    // the same frame goes on to each new limit until the counts settle it,
+    // which adaptIterations() guarantees without going back and forth
+    uint32_t limit;
+    while(done && adaptive
+          && (limit = adaptIterations(&budget, &view, rt->frame.iterations))
+             != view.MaxIterations)
+    {
+      view.MaxIterations = limit;
+      done = updateIterationFrame(&rt->frame, &view) == 0;
+    } // while
+    if(done && adaptive)
+      rt->limit = view.MaxIterations;
+
+    if(done)
+    {
+      finishFrameProbe(&probe, &stats);
+      double start = statsClock();
+      if(rt->frame.magnitudes != NULL)
+        colourSmooth(&view, rt->frame.iterations, rt->frame.magnitudes,
+                     &rt->frame_palette, rt->back);
+      else
+        colourIterations(&view, rt->frame.iterations, rt->back);
+      if(antialias > 1)
+        stats.refined = antialiasFrame(&view, rt->frame.iterations,
+                                       rt->frame.magnitudes != NULL
+                                       ? &rt->frame_palette : NULL,
+                                       antialias, rt->back);
+      stats.colour_ms = (statsClock() - start) * 1e3;
+      countFrameIterations(&stats, &view, rt->frame.iterations);
+      stats.reused = reused;
+      stats.frame = rt->frames++;
+    }
+
+    pthread_mutex_lock(&rt->lock);
+    // a frame of an older view is still shown: it is better than nothing
+    if(done)
+    {
+      rt->ready_stats = stats;
+      publish(rt, &view, true);
+    }
+  } // while
+  pthread_mutex_unlock(&rt->lock);
+
+  setRenderProgress(NULL, NULL);
+  setRenderCancelFlag(NULL);
+  return NULL;
+}
+
+static void freeBuffers(render_thread_t* rt)
+{
+  destroyIterationFrame(&rt->frame);
+  free(rt->back);
+  free(rt->ready);
+  free(rt);
+}
+
+render_thread_t* createRenderThread(uint32_t width, uint32_t height)
+{
+  render_thread_t* rt = calloc(1, sizeof(render_thread_t));
+  if(rt == NULL)
+    return NULL;
+
+  size_t count = (size_t)width * height;
+  rt->width = width;
+  rt->height = height;
+  rt->back = malloc(count * sizeof(uint32_t));
+  rt->ready = malloc(count * sizeof(uint32_t));
+  if(rt->back == NULL || rt->ready == NULL
+     || createIterationFrame(&rt->frame, width, height) == -1
+     || pipe(rt->pipe_fd) == -1)
+  {
+    freeBuffers(rt);
+    return NULL;
+  }
+  fcntl(rt->pipe_fd[0], F_SETFL, O_NONBLOCK);
+  fcntl(rt->pipe_fd[1], F_SETFL, O_NONBLOCK);
+
+  pthread_mutex_init(&rt->lock, NULL);
+  pthread_cond_init(&rt->wake, NULL);
+  if(pthread_create(&rt->thread, NULL, renderLoop, rt) != 0)
+  {
+    pthread_cond_destroy(&rt->wake);
+    pthread_mutex_destroy(&rt->lock);
+    close(rt->pipe_fd[0]);
+    close(rt->pipe_fd[1]);
+    freeBuffers(rt);
+    return NULL;
+  }
+  return rt;
+}
+
+void requestRender(render_thread_t* rt, const view_t* view)
+{
+  pthread_mutex_lock(&rt->lock);
+  rt->request = *view;
+  rt->pending = true;
+  __atomic_store_n(&rt->cancel, true, __ATOMIC_RELAXED);
+  pthread_cond_signal(&rt->wake);
+  pthread_mutex_unlock(&rt->lock);
+}
+
+void setRenderPalette(render_thread_t* rt, const palette_t* palette)
+{
+  pthread_mutex_lock(&rt->lock);
+  rt->smooth = palette != NULL;
+  if(palette != NULL)
+    rt->palette = *palette;
+  pthread_mutex_unlock(&rt->lock);
+}
+
+void setRenderIterationBudget(render_thread_t* rt,
+                              const iteration_budget_t* budget)
+{
+  pthread_mutex_lock(&rt->lock);
+  rt->adaptive = budget != NULL;
+  if(budget != NULL)
+    rt->budget = *budget;
+  pthread_mutex_unlock(&rt->lock);
+}
+
+void setRenderAntialias(render_thread_t* rt, unsigned grid)
+{
+  pthread_mutex_lock(&rt->lock);
+  rt->antialias = grid;
+  pthread_mutex_unlock(&rt->lock);
+}
+
+int renderThreadFd(const render_thread_t* rt)
+{
+  return rt->pipe_fd[0];
+}
+
+bool takeFrame(render_thread_t* rt, uint32_t* pixels, view_t* view,
+               bool* complete)
+{
+  char token;
+  while(read(rt->pipe_fd[0], &token, 1) > 0)
+    ;
+
+  pthread_mutex_lock(&rt->lock);
+  bool have = rt->have_ready;
+  if(have)
+  {
+    memcpy(pixels, rt->ready, (size_t)rt->width * rt->height * sizeof(uint32_t));
+    *view = rt->ready_view;
+    *complete = rt->ready_complete;
+    rt->have_ready = false;
+    if(rt->ready_complete)
+    {
+      rt->taken_stats = rt->ready_stats;
+      rt->have_stats = true;
+    }
+  }
+  pthread_mutex_unlock(&rt->lock);
+  return have;
+}
+
+bool lastFrameStats(const render_thread_t* rt, frame_stats_t* stats)
+{
+  if(rt->have_stats)
+    *stats = rt->taken_stats;
+  return rt->have_stats;
+}
+
+void destroyRenderThread(render_thread_t* rt)
+{
+  if(rt == NULL)
+    return;
+
+  pthread_mutex_lock(&rt->lock);
+  rt->quit = true;
+  __atomic_store_n(&rt->cancel, true, __ATOMIC_RELAXED);
+  pthread_cond_signal(&rt->wake);
+  pthread_mutex_unlock(&rt->lock);
+  pthread_join(rt->thread, NULL);
+
+  pthread_cond_destroy(&rt->wake);
+  pthread_mutex_destroy(&rt->lock);
+  close(rt->pipe_fd[0]);
+  close(rt->pipe_fd[1]);
+  freeBuffers(rt);
+}
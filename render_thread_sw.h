@@ -0,0 +1,71 @@
+#ifndef RENDER_THREAD_SW_H
+#define RENDER_THREAD_SW_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "render_sw.h"
+#include "frame_stats_sw.h"
+#include "palette_sw.h"
+#include "iteration_budget_sw.h"
+#include "antialias_sw.h"
+
+/*
+  Background render thread for the viewers. The X thread posts views and
+  keeps handling events while the worker renders the newest one into a
+  back buffer (reusing the previous frame's iterations, see
+  iteration_frame_sw.h). A new request cancels the frame in flight at tile
+  granularity. Finished frames are swapped with the ready buffer under a
+  lock, and a pipe wakes up the X thread's poll loop. In progressive mode
+  the coarse passes of a frame are published too, as incomplete frames.
+  With an iteration budget the worker picks each frame's MaxIterations
+  itself and takes the frame to it before publishing it.
+*/
+
+typedef struct render_thread render_thread_t;
+
+// Returns NULL if the thread or its buffers can't be created
+render_thread_t* createRenderThread(uint32_t width, uint32_t height);
+
+// Replaces any pending request and abandons the frame being rendered
+void requestRender(render_thread_t* rt, const view_t* view);
+
+// Colours the frames from the next request on smoothly with a copy of
+// palette, or with colourIterations() again if it is NULL. A request that
+// only changes the palette is recoloured from the kept counts without
+// iterating, except for the first smooth one, which needs |z|^2 as well.
+void setRenderPalette(render_thread_t* rt, const palette_t* palette);
+
+// Lets the worker choose the MaxIterations of the frames from the next
+// request on with a copy of budget, or take the requested one again if it
+// is NULL. A frame starts from the limit the last one settled on (or
+// zoomIterations() if that is higher) and is raised or lowered with
+// adaptIterations() until it settles; the capped pixels of a resumable
+// view carry on rather than start over. takeFrame() returns the limit in
+// the view.
+void setRenderIterationBudget(render_thread_t* rt,
+                              const iteration_budget_t* budget);
+
+// Supersamples the edge pixels of the complete frames from the next request
+// on with grid x grid samples each (see antialias_sw.h), 0 turns it off.
+// Previews are not antialiased, and the samples are iterated again for
+// every frame, one that only changes the palette included.
+void setRenderAntialias(render_thread_t* rt, unsigned grid);
+
+// Becomes readable when a finished frame is waiting for takeFrame()
+int renderThreadFd(const render_thread_t* rt);
+
+// Copies the newest finished frame to pixels and its view to *view, and
+// sets *complete unless it is a progressive preview. Returns false if no
+// frame has finished since the last call.
+bool takeFrame(render_thread_t* rt, uint32_t* pixels, view_t* view,
+               bool* complete);
+
+// Statistics of the last complete frame takeFrame() returned, see
+// frame_stats_sw.h; present_ms is left at 0 for the caller. Returns false
+// before the first one.
+bool lastFrameStats(const render_thread_t* rt, frame_stats_t* stats);
+
+void destroyRenderThread(render_thread_t* rt);
+
+#endif // RENDER_THREAD_SW_H
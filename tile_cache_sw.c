@@ -0,0 +1,252 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tile_cache_sw.h"
+
+// Buckets per tile the budget holds; chains stay short without resizing
+#define BUCKETS_PER_TILE 2
+
+typedef struct tile_entry tile_entry_t;
+
+struct tile_entry
+{
+  tile_key_t key;
+  tile_entry_t* chain;      // next entry of the same bucket
+  tile_entry_t* newer;      // LRU list, most recent at the head
+  tile_entry_t* older;
+  uint32_t counts[];
+};
+
+struct tile_cache
+{
+  pthread_mutex_t lock;
+  unsigned pixels;
+  size_t entry_size;
+  size_t budget;
+  size_t bytes;
+  size_t tiles;
+  size_t bucket_count;      // power of two
+  tile_entry_t** buckets;
+  tile_entry_t* newest;
+  tile_entry_t* oldest;
+  unsigned long hits;
+  unsigned long misses;
+  unsigned long evictions;
+};
+
+uint64_t hashTilePlane(uint64_t hash, const void* data, size_t size)
+{
+  const unsigned char* bytes = data;
+  for(size_t i = 0; i < size; i++)
+  {
+    hash ^= bytes[i];
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+static size_t bucketOf(const tile_cache_t* cache, const tile_key_t* key)
+{
+  uint64_t hash = hashTilePlane(key->plane, &key->x, sizeof(key->x));
+  hash = hashTilePlane(hash, &key->y, sizeof(key->y));
+  return hash & (cache->bucket_count - 1);
+}
+
+static bool sameKey(const tile_key_t* a, const tile_key_t* b)
+{
+  return a->plane == b->plane && a->x == b->x && a->y == b->y;
+}
+
+static tile_entry_t* findEntry(tile_cache_t* cache, const tile_key_t* key)
+{
+  tile_entry_t* entry = cache->buckets[bucketOf(cache, key)];
+  while(entry != NULL && !sameKey(&entry->key, key))
+    entry = entry->chain;
+  return entry;
+}
+
+static void unlinkEntry(tile_cache_t* cache, tile_entry_t* entry)
+{
+  if(entry->newer != NULL)
+    entry->newer->older = entry->older;
+  else
+    cache->newest = entry->older;
+  if(entry->older != NULL)
+    entry->older->newer = entry->newer;
+  else
+    cache->oldest = entry->newer;
+}
+
+static void pushNewest(tile_cache_t* cache, tile_entry_t* entry)
+{
+  entry->newer = NULL;
+  entry->older = cache->newest;
+  if(cache->newest != NULL)
+    cache->newest->newer = entry;
+  else
+    cache->oldest = entry;
+  cache->newest = entry;
+}
+
+static void removeEntry(tile_cache_t* cache, tile_entry_t* entry)
+{
+  tile_entry_t** link = &cache->buckets[bucketOf(cache, &entry->key)];
+  while(*link != entry)
+    link = &(*link)->chain;
+  *link = entry->chain;
+
+  unlinkEntry(cache, entry);
+  cache->bytes -= cache->entry_size;
+  cache->tiles--;
+  free(entry);
+}
+
+// Drops the least recently used tiles until at most bytes are left
+static void evictTo(tile_cache_t* cache, size_t bytes)
+{
+  while(cache->oldest != NULL && cache->bytes > bytes)
+  {
+    removeEntry(cache, cache->oldest);
+    cache->evictions++;
+  }
+}
+
+// Bucket array sized for the budget, NULL if that can't be allocated
+static tile_entry_t** allocateBuckets(size_t budget, size_t entry_size,
+                                      size_t* count)
+{
+  size_t wanted = budget / entry_size * BUCKETS_PER_TILE;
+  *count = 1;
+  while(*count < wanted)
+    *count *= 2;
+  return calloc(*count, sizeof(tile_entry_t*));
+}
+
+tile_cache_t* createTileCache(size_t budget, unsigned pixels)
+{
+  tile_cache_t* cache = calloc(1, sizeof(*cache));
+  if(cache == NULL)
+    return NULL;
+
+  cache->pixels = pixels;
+  cache->entry_size = sizeof(tile_entry_t) + pixels * sizeof(uint32_t);
+  cache->budget = budget;
+  cache->buckets = allocateBuckets(budget, cache->entry_size,
+                                   &cache->bucket_count);
+  if(cache->buckets == NULL)
+  {
+    free(cache);
+    return NULL;
+  }
+  pthread_mutex_init(&cache->lock, NULL);
+  return cache;
+}
+
+void setTileCacheLimit(tile_cache_t* cache, size_t budget)
+{
+  pthread_mutex_lock(&cache->lock);
+  evictTo(cache, budget);
+  cache->budget = budget;
+
+  // rehash into a table sized for the new budget, keeping the old one if
+  // the allocation fails
+  size_t count;
+  tile_entry_t** buckets = allocateBuckets(budget, cache->entry_size, &count);
+  if(buckets != NULL)
+  {
+    free(cache->buckets);
+    cache->buckets = buckets;
+    cache->bucket_count = count;
+    for(tile_entry_t* entry = cache->newest; entry != NULL;
+        entry = entry->older)
+    {
+      size_t bucket = bucketOf(cache, &entry->key);
+      entry->chain = buckets[bucket];
+      buckets[bucket] = entry;
+    }
+  }
+  pthread_mutex_unlock(&cache->lock);
+}
+
+bool tileCacheLookup(tile_cache_t* cache, const tile_key_t* key,
+                     uint32_t* counts)
+{
+  pthread_mutex_lock(&cache->lock);
+  tile_entry_t* entry = findEntry(cache, key);
+  if(entry != NULL)
+  {
+    memcpy(counts, entry->counts, cache->pixels * sizeof(uint32_t));
+    unlinkEntry(cache, entry);
+    pushNewest(cache, entry);
+    cache->hits++;
+  }
+  else
+  {
+    cache->misses++;
+  }
+  pthread_mutex_unlock(&cache->lock);
+  return entry != NULL;
+}
+
+void tileCacheInsert(tile_cache_t* cache, const tile_key_t* key,
+                     const uint32_t* counts)
+{
+  pthread_mutex_lock(&cache->lock);
+  if(cache->entry_size > cache->budget)
+  {
+    pthread_mutex_unlock(&cache->lock);
+    return;
+  }
+
+  tile_entry_t* entry = findEntry(cache, key);
+  if(entry != NULL)
+  {
+    unlinkEntry(cache, entry);
+  }
+  else
+  {
+    evictTo(cache, cache->budget - cache->entry_size);
+    entry = malloc(cache->entry_size);
+    if(entry == NULL)
+    {
+      pthread_mutex_unlock(&cache->lock);
+      return;
+    }
+    entry->key = *key;
+    size_t bucket = bucketOf(cache, key);
+    entry->chain = cache->buckets[bucket];
+    cache->buckets[bucket] = entry;
+    cache->bytes += cache->entry_size;
+    cache->tiles++;
+  }
+  memcpy(entry->counts, counts, cache->pixels * sizeof(uint32_t));
+  pushNewest(cache, entry);
+  pthread_mutex_unlock(&cache->lock);
+}
+
+tile_cache_stats_t tileCacheStats(tile_cache_t* cache)
+{
+  pthread_mutex_lock(&cache->lock);
+  tile_cache_stats_t stats = {
+    .hits = cache->hits,
+    .misses = cache->misses,
+    .evictions = cache->evictions,
+    .tiles = cache->tiles,
+    .bytes = cache->bytes,
+    .budget = cache->budget
+  };
+  pthread_mutex_unlock(&cache->lock);
+  return stats;
+}
+
+void destroyTileCache(tile_cache_t* cache)
+{
+  if(cache == NULL)
+    return;
+  while(cache->oldest != NULL)
+    removeEntry(cache, cache->oldest);
+  free(cache->buckets);
+  pthread_mutex_destroy(&cache->lock);
+  free(cache);
+}
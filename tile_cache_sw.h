@@ -0,0 +1,60 @@
+#ifndef TILE_CACHE_SW_H
+#define TILE_CACHE_SW_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+  LRU cache of square tiles of iteration counts, bounded by a memory
+  budget. A tile is named by the plane it belongs to (a hash of everything
+  that decides the counts: fractal, number format, pixel lattice and
+  MaxIterations) and its position on that plane's tile grid. Lookups and
+  inserts are safe from several threads at once.
+*/
+
+typedef struct tile_cache tile_cache_t;
+
+typedef struct
+{
+  uint64_t plane;
+  int64_t x;        // tile column and row on the plane's grid
+  int64_t y;
+} tile_key_t;
+
+typedef struct
+{
+  unsigned long hits;
+  unsigned long misses;
+  unsigned long evictions;
+  size_t tiles;     // tiles held now
+  size_t bytes;     // memory they take, at most budget
+  size_t budget;
+} tile_cache_stats_t;
+
+// Tiles hold pixels counts each. A budget too small for one tile gives a
+// cache that never holds anything.
+tile_cache_t* createTileCache(size_t budget, unsigned pixels);
+
+// Evicts the least recently used tiles until the rest fit
+void setTileCacheLimit(tile_cache_t* cache, size_t budget);
+
+// Copies the tile's counts to counts and marks it most recently used.
+// Returns false (a miss) if the cache doesn't hold it.
+bool tileCacheLookup(tile_cache_t* cache, const tile_key_t* key,
+                     uint32_t* counts);
+
+// Stores a copy of counts under key, replacing an older tile of that key
+void tileCacheInsert(tile_cache_t* cache, const tile_key_t* key,
+                     const uint32_t* counts);
+
+tile_cache_stats_t tileCacheStats(tile_cache_t* cache);
+
+void destroyTileCache(tile_cache_t* cache);
+
+// FNV-1a over size bytes, chained through hash; start with
+// TILE_PLANE_SEED
+#define TILE_PLANE_SEED 0xcbf29ce484222325ull
+uint64_t hashTilePlane(uint64_t hash, const void* data, size_t size);
+
+#endif // TILE_CACHE_SW_H
@@ -0,0 +1,246 @@
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "tile_pool_sw.h"
+
+// Remaining tiles of one worker, padded to its own cache line
+typedef struct
+{
+  pthread_mutex_t lock;
+  unsigned begin;
+  unsigned end;
+} __attribute__((aligned(64))) tile_queue_t;
+
+typedef struct
+{
+  tile_pool_t* pool;
+  unsigned id;
+} worker_arg_t;
+
+struct tile_pool
+{
+  unsigned threads;
+  pthread_t* workers;       // threads - 1 helpers, the caller is thread 0
+  worker_arg_t* args;
+  tile_queue_t* queues;
+  double* busy;             // seconds per thread, written by that thread
+
+  pthread_mutex_t lock;
+  pthread_cond_t start;
+  pthread_cond_t done;
+  unsigned generation;      // bumped for every batch
+  unsigned active;          // helpers still busy with the current batch
+  bool quit;
+
+  tile_fn_t fn;
+  void* context;
+};
+
+static bool popTile(tile_queue_t* queue, unsigned* tile)
+{
+  bool found = false;
+  pthread_mutex_lock(&queue->lock);
+  if(queue->begin < queue->end)
+  {
+    *tile = queue->begin++;
+    found = true;
+  }
+  pthread_mutex_unlock(&queue->lock);
+  return found;
+}
+
+// Moves the upper half of some other worker's range into our own queue
+static bool stealTiles(tile_pool_t* pool, unsigned id)
+{
+  for(unsigned i = 1; i < pool->threads; i++)
+  {
+    tile_queue_t* victim = &pool->queues[(id + i) % pool->threads];
+    unsigned begin = 0, end = 0;
+
+    pthread_mutex_lock(&victim->lock);
+    unsigned remaining = victim->end - victim->begin;
+    if(remaining > 0)
+    {
+      end = victim->end;
+      begin = end - (remaining + 1) / 2;
+      victim->end = begin;
+    }
+    pthread_mutex_unlock(&victim->lock);
+
+    if(begin < end)
+    {
+      tile_queue_t* own = &pool->queues[id];
+      pthread_mutex_lock(&own->lock);
+      own->begin = begin;
+      own->end = end;
+      pthread_mutex_unlock(&own->lock);
+      return true;
+    }
+  }
+  return false;
+}
+
+static double now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void workBatch(tile_pool_t* pool, unsigned id)
+{
+  double start = now();
+  unsigned tile;
+  do
+  {
+    while(popTile(&pool->queues[id], &tile))
+      pool->fn(pool->context, tile, id);
+  } while(stealTiles(pool, id));
+  pool->busy[id] += now() - start;
+}
+
+static void* workerMain(void* arg)
+{
+  tile_pool_t* pool = ((worker_arg_t*)arg)->pool;
+  unsigned id = ((worker_arg_t*)arg)->id;
+  unsigned seen = 0;
+
+  pthread_mutex_lock(&pool->lock);
+  while(true)
+  {
+    while(pool->generation == seen && !pool->quit)
+      pthread_cond_wait(&pool->start, &pool->lock);
+    if(pool->quit)
+      break;
+    seen = pool->generation;
+    pthread_mutex_unlock(&pool->lock);
+
+    workBatch(pool, id);
+
+    pthread_mutex_lock(&pool->lock);
+    if(--pool->active == 0)
+      pthread_cond_signal(&pool->done);
+  }
+  pthread_mutex_unlock(&pool->lock);
+  return NULL;
+}
+
+tile_pool_t* createTilePool(unsigned threads)
+{
+  if(threads == 0)
+  {
+    const char* env = getenv("MANDELBROT_THREADS");
+    long count = env != NULL ? atol(env) : sysconf(_SC_NPROCESSORS_ONLN);
+    threads = count > 0 ? count : 1;
+  }
+
+  tile_pool_t* pool = calloc(1, sizeof(tile_pool_t));
+  if(pool == NULL)
+    return NULL;
+
+  pool->threads = threads;
+  pool->workers = calloc(threads, sizeof(pthread_t));
+  pool->args = calloc(threads, sizeof(worker_arg_t));
+  pool->busy = calloc(threads, sizeof(double));
+  if(posix_memalign((void**)&pool->queues, 64,
+                    threads * sizeof(tile_queue_t)) != 0)
+    pool->queues = NULL;
+  if(pool->workers == NULL || pool->args == NULL || pool->queues == NULL
+     || pool->busy == NULL)
+  {
+    free(pool->workers);
+    free(pool->args);
+    free(pool->queues);
+    free(pool->busy);
+    free(pool);
+    return NULL;
+  }
+
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->start, NULL);
+  pthread_cond_init(&pool->done, NULL);
+  for(unsigned i = 0; i < threads; i++)
+  {
+    pthread_mutex_init(&pool->queues[i].lock, NULL);
+    pool->queues[i].begin = pool->queues[i].end = 0;
+  }
+
+  for(unsigned i = 1; i < threads; i++)
+  {
+    pool->args[i].pool = pool;
+    pool->args[i].id = i;
+    if(pthread_create(&pool->workers[i], NULL, workerMain, &pool->args[i]) != 0)
+    {
+      // run with the helpers we managed to start
+      pool->threads = i;
+      break;
+    }
+  }
+  return pool;
+}
+
+unsigned tilePoolThreads(const tile_pool_t* pool)
+{
+  return pool->threads;
+}
+
+void runTiles(tile_pool_t* pool, unsigned count, tile_fn_t fn, void* context)
+{
+  // contiguous initial shares keep neighbouring tiles on the same core
+  for(unsigned i = 0; i < pool->threads; i++)
+  {
+    pool->queues[i].begin = (unsigned)((unsigned long)count * i / pool->threads);
+    pool->queues[i].end =
+      (unsigned)((unsigned long)count * (i + 1) / pool->threads);
+  }
+
+  pthread_mutex_lock(&pool->lock);
+  pool->fn = fn;
+  pool->context = context;
+  pool->active = pool->threads - 1;
+  pool->generation++;
+  pthread_cond_broadcast(&pool->start);
+  pthread_mutex_unlock(&pool->lock);
+
+  workBatch(pool, 0);
+
+  pthread_mutex_lock(&pool->lock);
+  while(pool->active > 0)
+    pthread_cond_wait(&pool->done, &pool->lock);
+  pthread_mutex_unlock(&pool->lock);
+}
+
+void tilePoolBusy(const tile_pool_t* pool, double* seconds)
+{
+  for(unsigned i = 0; i < pool->threads; i++)
+    seconds[i] = pool->busy[i];
+}
+
+void destroyTilePool(tile_pool_t* pool)
+{
+  if(pool == NULL)
+    return;
+
+  pthread_mutex_lock(&pool->lock);
+  pool->quit = true;
+  pthread_cond_broadcast(&pool->start);
+  pthread_mutex_unlock(&pool->lock);
+
+  for(unsigned i = 1; i < pool->threads; i++)
+    pthread_join(pool->workers[i], NULL);
+
+  for(unsigned i = 0; i < pool->threads; i++)
+    pthread_mutex_destroy(&pool->queues[i].lock);
+  pthread_mutex_destroy(&pool->lock);
+  pthread_cond_destroy(&pool->start);
+  pthread_cond_destroy(&pool->done);
+
+  free(pool->workers);
+  free(pool->args);
+  free(pool->queues);
+  free(pool->busy);
+  free(pool);
+}
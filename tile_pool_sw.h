@@ -0,0 +1,31 @@
+#ifndef TILE_POOL_SW_H
+#define TILE_POOL_SW_H
+
+/*
+  Fixed pool of pthreads that runs a batch of independent tiles. Every
+  worker starts with a contiguous share of the tile range and, once it runs
+  dry, steals half of the remaining range of another worker, so expensive
+  tiles (deep in the set) don't leave the other threads idle.
+*/
+
+typedef struct tile_pool tile_pool_t;
+
+// Called once per tile; thread is in [0, tilePoolThreads())
+typedef void (*tile_fn_t)(void* context, unsigned tile, unsigned thread);
+
+// threads == 0 picks $MANDELBROT_THREADS or the number of online CPUs
+tile_pool_t* createTilePool(unsigned threads);
+
+unsigned tilePoolThreads(const tile_pool_t* pool);
+
+// Runs fn for tiles [0, count) and returns once all of them are done. The
+// calling thread works as thread 0.
+void runTiles(tile_pool_t* pool, unsigned count, tile_fn_t fn, void* context);
+
+// Seconds each thread has spent on tiles since the pool was created, one
+// entry per thread. Only valid between runTiles() calls.
+void tilePoolBusy(const tile_pool_t* pool, double* seconds);
+
+void destroyTilePool(tile_pool_t* pool);
+
+#endif // TILE_POOL_SW_H
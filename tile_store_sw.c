@@ -0,0 +1,413 @@
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "tile_store_sw.h"
+
+#define STORE_MAGIC "MBTILES1"
+#define RECORD_MAGIC 0x454c4954u  // "TILE"
+
+typedef struct
+{
+  char magic[8];
+  uint32_t pixels;
+  uint32_t version;         // STORE_VERSION of the writer
+} store_header_t;
+
+typedef struct
+{
+  uint32_t magic;
+  uint32_t size;            // compressed bytes following the header
+  tile_key_t key;
+} record_header_t;
+
+typedef struct
+{
+  tile_key_t key;
+  uint64_t offset;          // of the record header
+} index_entry_t;
+
+typedef struct
+{
+  tile_key_t key;
+  uint32_t* counts;
+} pending_tile_t;
+
+struct tile_store
+{
+  pthread_mutex_t lock;
+  int fd;
+  unsigned pixels;
+  const unsigned char* map;
+  uint64_t mapped;          // bytes of the file in map
+  uint64_t size;            // end of the last record
+
+  index_entry_t* entries;
+  size_t count;
+  size_t capacity;
+  uint32_t* slots;          // open addressing, entry + 1, 0 is empty
+  size_t slot_count;        // power of two, at least twice count
+
+  pending_tile_t* pending;  // tiles not written yet
+  size_t pending_count;
+  size_t pending_capacity;
+  z_stream deflater;        // reused for every tile
+  z_stream inflater;
+  bool streams;             // both initialised
+
+  unsigned long hits;
+  unsigned long misses;
+  unsigned long written;
+};
+
+static size_t slotOf(const tile_store_t* store, const tile_key_t* key)
+{
+  uint64_t hash = hashTilePlane(key->plane, &key->x, sizeof(key->x));
+  hash = hashTilePlane(hash, &key->y, sizeof(key->y));
+  return hash & (store->slot_count - 1);
+}
+
+// Slot holding key, or the empty slot where it would go
+static size_t findSlot(const tile_store_t* store, const tile_key_t* key)
+{
+  size_t slot = slotOf(store, key);
+  while(store->slots[slot] != 0)
+  {
+    const tile_key_t* other = &store->entries[store->slots[slot] - 1].key;
+    if(other->plane == key->plane && other->x == key->x && other->y == key->y)
+      break;
+    slot = (slot + 1) & (store->slot_count - 1);
+  }
+  return slot;
+}
+
+static bool growIndex(tile_store_t* store)
+{
+  if(store->count == store->capacity)
+  {
+    size_t capacity = store->capacity ? store->capacity * 2 : 1024;
+    index_entry_t* entries = realloc(store->entries,
+                                     capacity * sizeof(index_entry_t));
+    if(entries == NULL)
+      return false;
+    store->entries = entries;
+    store->capacity = capacity;
+  }
+  if(2 * (store->count + 1) > store->slot_count)
+  {
+    size_t slot_count = store->slot_count ? store->slot_count * 2 : 2048;
+    uint32_t* slots = calloc(slot_count, sizeof(uint32_t));
+    if(slots == NULL)
+      return false;
+    free(store->slots);
+    store->slots = slots;
+    store->slot_count = slot_count;
+    for(size_t i = 0; i < store->count; i++)
+      slots[findSlot(store, &store->entries[i].key)] = i + 1;
+  }
+  return true;
+}
+
+// Indexes the record at offset, a later record of the same key wins
+static void indexRecord(tile_store_t* store, const tile_key_t* key,
+                        uint64_t offset)
+{
+  if(!growIndex(store))
+    return;
+  size_t slot = findSlot(store, key);
+  if(store->slots[slot] != 0)
+  {
+    store->entries[store->slots[slot] - 1].offset = offset;
+    return;
+  }
+  store->entries[store->count] = (index_entry_t){*key, offset};
+  store->slots[slot] = ++store->count;
+}
+
+// Maps the whole file again so that records appended since are in map
+static bool remap(tile_store_t* store)
+{
+  struct stat st;
+  if(fstat(store->fd, &st) != 0)
+    return false;
+  if(store->map != NULL)
+    munmap((void*)store->map, store->mapped);
+  store->map = NULL;
+  store->mapped = 0;
+  if(st.st_size == 0)
+    return true;
+
+  void* map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, store->fd, 0);
+  if(map == MAP_FAILED)
+    return false;
+  store->map = map;
+  store->mapped = st.st_size;
+  return true;
+}
+
+// Indexes every whole record and cuts off a torn one at the end
+static void scanRecords(tile_store_t* store)
+{
+  uint64_t offset = sizeof(store_header_t);
+  while(offset + sizeof(record_header_t) <= store->mapped)
+  {
+    record_header_t record;
+    memcpy(&record, store->map + offset, sizeof(record));
+    uint64_t end = offset + sizeof(record) + record.size;
+    if(record.magic != RECORD_MAGIC || end > store->mapped)
+      break;
+    indexRecord(store, &record.key, offset);
+    offset = end;
+  }
+  store->size = offset;
+  if(offset < store->mapped && ftruncate(store->fd, offset) == 0)
+    remap(store);
+}
+
+tile_store_t* openTileStore(const char* path, unsigned pixels)
+{
+  tile_store_t* store = calloc(1, sizeof(*store));
+  if(store == NULL)
+    return NULL;
+  pthread_mutex_init(&store->lock, NULL);
+  store->pixels = pixels;
+  store->streams = deflateInit(&store->deflater, Z_BEST_SPEED) == Z_OK;
+  if(store->streams && inflateInit(&store->inflater) != Z_OK)
+  {
+    deflateEnd(&store->deflater);
+    store->streams = false;
+  }
+  store->fd = open(path, O_RDWR | O_CREAT, 0644);
+  if(store->fd < 0 || !store->streams)
+  {
+    closeTileStore(store);
+    return NULL;
+  }
+
+  // a new file gets its header under the lock, in case two processes
+  // create it at once; a store of another version holds counts this build
+  // would not compute, so it is emptied and starts over
+  store_header_t header;
+  flock(store->fd, LOCK_EX);
+  bool valid = remap(store);
+  if(valid && store->mapped >= sizeof(header))
+  {
+    memcpy(&header, store->map, sizeof(header));
+    if(memcmp(header.magic, STORE_MAGIC, sizeof(header.magic)) == 0
+       && header.pixels == pixels && header.version != STORE_VERSION)
+      valid = ftruncate(store->fd, 0) == 0 && remap(store);
+  }
+  if(valid && store->mapped == 0)
+  {
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, STORE_MAGIC, sizeof(header.magic));
+    header.pixels = pixels;
+    header.version = STORE_VERSION;
+    valid = pwrite(store->fd, &header, sizeof(header), 0) == sizeof(header)
+            && remap(store);
+  }
+  if(valid && store->mapped >= sizeof(header))
+  {
+    memcpy(&header, store->map, sizeof(header));
+    valid = memcmp(header.magic, STORE_MAGIC, sizeof(header.magic)) == 0
+            && header.pixels == pixels && header.version == STORE_VERSION;
+  }
+  else
+  {
+    valid = false;
+  }
+  if(valid)
+    scanRecords(store);
+  flock(store->fd, LOCK_UN);
+
+  if(!valid)
+  {
+    closeTileStore(store);
+    return NULL;
+  }
+  return store;
+}
+
+bool tileStoreLookup(tile_store_t* store, const tile_key_t* key,
+                     uint32_t* counts)
+{
+  bool found = false;
+  pthread_mutex_lock(&store->lock);
+  size_t slot = store->slots != NULL ? findSlot(store, key) : 0;
+  if(store->slots != NULL && store->slots[slot] != 0)
+  {
+    uint64_t offset = store->entries[store->slots[slot] - 1].offset;
+    record_header_t record;
+    if(offset + sizeof(record) > store->mapped)
+      remap(store);
+    if(offset + sizeof(record) <= store->mapped)
+    {
+      memcpy(&record, store->map + offset, sizeof(record));
+      if(offset + sizeof(record) + record.size > store->mapped)
+        remap(store);
+      if(offset + sizeof(record) + record.size <= store->mapped)
+      {
+        inflateReset(&store->inflater);
+        store->inflater.next_in = (Bytef*)store->map + offset
+                                  + sizeof(record);
+        store->inflater.avail_in = record.size;
+        store->inflater.next_out = (Bytef*)counts;
+        store->inflater.avail_out = store->pixels * sizeof(uint32_t);
+        found = inflate(&store->inflater, Z_FINISH) == Z_STREAM_END
+                && store->inflater.avail_out == 0;
+      }
+    }
+  }
+  if(found)
+    store->hits++;
+  else
+    store->misses++;
+  pthread_mutex_unlock(&store->lock);
+  return found;
+}
+
+void tileStoreAppend(tile_store_t* store, const tile_key_t* key,
+                     const uint32_t* counts)
+{
+  size_t length = store->pixels * sizeof(uint32_t);
+
+  // compressed when flushed, where one stream serves every tile
+  pthread_mutex_lock(&store->lock);
+  if(store->slots == NULL || store->slots[findSlot(store, key)] == 0)
+  {
+    if(store->pending_count == store->pending_capacity)
+    {
+      size_t capacity = store->pending_capacity * 2 + 16;
+      pending_tile_t* pending = realloc(store->pending,
+                                        capacity * sizeof(pending_tile_t));
+      if(pending != NULL)
+      {
+        store->pending = pending;
+        store->pending_capacity = capacity;
+      }
+    }
+    uint32_t* copy = malloc(length);
+    if(copy != NULL && store->pending_count < store->pending_capacity)
+    {
+      memcpy(copy, counts, length);
+      store->pending[store->pending_count++] = (pending_tile_t){*key, copy};
+    }
+    else
+    {
+      free(copy);
+    }
+  }
+  pthread_mutex_unlock(&store->lock);
+}
+
+// Records of the queued tiles back to back, NULL on failure
+static unsigned char* packPending(tile_store_t* store, size_t* size)
+{
+  uLong length = store->pixels * sizeof(uint32_t);
+  size_t bound = sizeof(record_header_t) + deflateBound(&store->deflater,
+                                                        length);
+  unsigned char* records = malloc(bound * store->pending_count);
+  if(records == NULL)
+    return NULL;
+
+  *size = 0;
+  for(size_t i = 0; i < store->pending_count; i++)
+  {
+    unsigned char* record = records + *size;
+    deflateReset(&store->deflater);
+    store->deflater.next_in = (Bytef*)store->pending[i].counts;
+    store->deflater.avail_in = length;
+    store->deflater.next_out = record + sizeof(record_header_t);
+    store->deflater.avail_out = bound - sizeof(record_header_t);
+    if(deflate(&store->deflater, Z_FINISH) != Z_STREAM_END)
+    {
+      free(records);
+      return NULL;
+    }
+
+    record_header_t header = {
+      .magic = RECORD_MAGIC,
+      .size = store->deflater.total_out,
+      .key = store->pending[i].key
+    };
+    memcpy(record, &header, sizeof(header));
+    *size += sizeof(header) + header.size;
+  }
+  return records;
+}
+
+void flushTileStore(tile_store_t* store)
+{
+  pthread_mutex_lock(&store->lock);
+  size_t size = 0;
+  unsigned char* records = store->pending_count > 0
+                           ? packPending(store, &size) : NULL;
+  if(records != NULL)
+  {
+    // other processes may have appended, so write at the current end
+    struct stat st;
+    flock(store->fd, LOCK_EX);
+    if(fstat(store->fd, &st) == 0
+       && pwrite(store->fd, records, size, st.st_size) == (ssize_t)size)
+    {
+      for(size_t offset = 0; offset < size;)
+      {
+        record_header_t header;
+        memcpy(&header, records + offset, sizeof(header));
+        indexRecord(store, &header.key, st.st_size + offset);
+        store->written++;
+        offset += sizeof(header) + header.size;
+      }
+      store->size = st.st_size + size;
+    }
+    flock(store->fd, LOCK_UN);
+    free(records);
+  }
+
+  for(size_t i = 0; i < store->pending_count; i++)
+    free(store->pending[i].counts);
+  store->pending_count = 0;
+  pthread_mutex_unlock(&store->lock);
+}
+
+tile_store_stats_t tileStoreStats(tile_store_t* store)
+{
+  pthread_mutex_lock(&store->lock);
+  tile_store_stats_t stats = {
+    .hits = store->hits,
+    .misses = store->misses,
+    .written = store->written,
+    .tiles = store->count,
+    .bytes = store->size
+  };
+  pthread_mutex_unlock(&store->lock);
+  return stats;
+}
+
+void closeTileStore(tile_store_t* store)
+{
+  if(store == NULL)
+    return;
+  if(store->fd >= 0 && store->streams)
+    flushTileStore(store);
+  if(store->map != NULL)
+    munmap((void*)store->map, store->mapped);
+  if(store->fd >= 0)
+    close(store->fd);
+  pthread_mutex_destroy(&store->lock);
+  free(store->entries);
+  free(store->slots);
+  free(store->pending);
+  if(store->streams)
+  {
+    deflateEnd(&store->deflater);
+    inflateEnd(&store->inflater);
+  }
+  free(store);
+}
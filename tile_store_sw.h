@@ -0,0 +1,58 @@
+#ifndef TILE_STORE_SW_H
+#define TILE_STORE_SW_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "tile_cache_sw.h"
+
+/*
+  Tiles of iteration counts kept on disk between runs, so that a new
+  process serves regions rendered before without iterating them. The file
+  is a header followed by records, appended in batches as tiles are
+  computed: a record header with the tile_key_t (plane and grid position)
+  and the tile's counts compressed with zlib. Opening the store maps the
+  file and indexes its records in memory; a record cut short by a crash is
+  dropped. Safe to use from several threads; several processes may share a
+  file but only see each other's tiles after reopening it. The header
+  records STORE_VERSION, and a store written by another version is emptied
+  when it is opened.
+*/
+
+// Version of the counts in a store: bump it whenever tilePlane() or the
+// kernels change, so that tiles computed before aren't served for planes
+// that would now come out differently
+#define STORE_VERSION 1
+
+typedef struct tile_store tile_store_t;
+
+typedef struct
+{
+  unsigned long hits;
+  unsigned long misses;
+  unsigned long written;    // tiles appended by this process
+  unsigned long tiles;      // tiles indexed
+  uint64_t bytes;           // file size
+} tile_store_stats_t;
+
+// Opens or creates the store at path for tiles of pixels counts, emptying
+// it if it was written by another STORE_VERSION. Returns NULL if the file
+// can't be opened or belongs to another tile size.
+tile_store_t* openTileStore(const char* path, unsigned pixels);
+
+// Decompresses the tile's counts to counts, false if the store has none
+bool tileStoreLookup(tile_store_t* store, const tile_key_t* key,
+                     uint32_t* counts);
+
+// Queues the tile for the file unless the store has it already
+void tileStoreAppend(tile_store_t* store, const tile_key_t* key,
+                     const uint32_t* counts);
+
+// Writes the queued tiles in one go, closing the store does it as well
+void flushTileStore(tile_store_t* store);
+
+tile_store_stats_t tileStoreStats(tile_store_t* store);
+
+void closeTileStore(tile_store_t* store);
+
+#endif // TILE_STORE_SW_H